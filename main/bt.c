@@ -13,17 +13,22 @@
 #include "nvs_flash.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/stream_buffer.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "esp_bt.h"
 #include "esp_bt_main.h"
 #include "esp_gap_bt_api.h"
 #include "esp_bt_device.h"
 #include "esp_spp_api.h"
+#include "sdkconfig.h"
 
 #include "time.h"
 #include "sys/time.h"
 
 #include "bt.h"
+#include "cmd.h"
+#include "dlog.h"
 
 #define SPP_TAG             "SPP_ACCEPTOR_DEMO"
 #define SPP_SERVER_NAME     "SPP_SERVER"
@@ -32,6 +37,14 @@
 #define SPP_SHOW_SPEED      1
 #define SPP_SHOW_MODE       SPP_SHOW_SPEED    /*Escolha o modo de exibição: mostrar dados ou velocidade*/
 
+// Buffer limitado entre o callback SPP e a tarefa que interpreta os comandos
+#define SPP_RX_BUFFER_SIZE      (CONFIG_EXAMPLE_SPP_RX_BUFFER_SIZE)
+#define SPP_CMD_TASK_STACK_SIZE (CONFIG_EXAMPLE_SPP_CMD_TASK_STACK_SIZE)
+#define SPP_CMD_TASK_PRIORITY   (5)
+#define SPP_CMD_LINE_SIZE       (32)
+#define SPP_RX_CHUNK_SIZE       (64)
+#define SPP_STATS_PERIOD_S      (3)
+
 static const esp_bt_pin_code_t PIN_CODE = {'1', '0', '1', '0', '1', '0', '1', '0', '1'};
 #define PIN_CODE_LEN (9)
 
@@ -43,6 +56,18 @@ static const bool esp_spp_enable_l2cap_ertm = true;
 static struct timeval time_new, time_old;
 static long data_num = 0;
 
+static StreamBufferHandle_t spp_rx_stream = NULL;  // dados recebidos, ainda não interpretados
+
+// Instrumentação do caminho de recepção (escrita apenas pelo callback SPP, sob rx_stats_lock)
+static portMUX_TYPE rx_stats_lock = portMUX_INITIALIZER_UNLOCKED;
+static struct spp_rx_stats {
+    uint32_t cb_count;      // quantidade de ESP_SPP_DATA_IND_EVT
+    uint32_t cb_time_max;   // maior tempo no callback (us)
+    uint64_t cb_time_total; // soma dos tempos no callback (us)
+    uint32_t level_max;     // maior ocupação do buffer (bytes)
+    uint32_t dropped;       // bytes descartados por buffer cheio
+} rx_stats;
+
 static const esp_spp_sec_t sec_mask = ESP_SPP_SEC_AUTHENTICATE;
 static const esp_spp_role_t role_slave = ESP_SPP_ROLE_SLAVE;
 
@@ -65,11 +90,34 @@ static void print_speed(void)
     float time_interval = time_new_s - time_old_s;
     float speed = data_num * 8 / time_interval / 1000.0;
     ESP_LOGI(SPP_TAG, "speed(%fs ~ %fs): %f kbit/s" , time_old_s, time_new_s, speed);
+    // Cópia consistente: cb_time_total tem 64 bits e poderia ser lido pela metade durante uma atualização
+    taskENTER_CRITICAL(&rx_stats_lock);
+    struct spp_rx_stats st = rx_stats;
+    taskEXIT_CRITICAL(&rx_stats_lock);
+    ESP_LOGI(SPP_TAG, "rx: cb=%"PRIu32" cb_avg=%"PRIu32"us cb_max=%"PRIu32"us buf=%u/%u buf_max=%"PRIu32" dropped=%"PRIu32,
+             st.cb_count, st.cb_count ? (uint32_t)(st.cb_time_total / st.cb_count) : 0, st.cb_time_max,
+             (unsigned)xStreamBufferBytesAvailable(spp_rx_stream), (unsigned)SPP_RX_BUFFER_SIZE,
+             st.level_max, st.dropped);
     data_num = 0;
     time_old.tv_sec = time_new.tv_sec;
     time_old.tv_usec = time_new.tv_usec;
 }
 
+#if CONFIG_ZPHS01B_DEFERRED_LOG
+/*
+Expande um registro DLOG_MSG_SENT (tamanho da mensagem enviada) na tarefa de log adiado.
+*/
+static void expand_msg_sent(const void *args, size_t len)
+{
+    uint32_t sent;
+    if (len != sizeof(sent)) {
+        return;
+    }
+    memcpy(&sent, args, sizeof(sent));
+    ESP_LOGI(SPP_TAG, "Message sent (%"PRIu32" bytes)", sent);
+}
+#endif
+
 /*
 Esta função usa uma string terminada em zero com a mensagem.
 */
@@ -79,8 +127,14 @@ void send_message(const char *message)
         return;
     }
     if (spp_handle != 0) {
-        esp_spp_write(spp_handle, strlen(message), (uint8_t *)message);
+        uint32_t len = strlen(message);
+        esp_spp_write(spp_handle, len, (uint8_t *)message);
+#if CONFIG_ZPHS01B_DEFERRED_LOG
+        // O texto já aparece no log OUTPUT_MSG; aqui basta o tamanho
+        dlog_write(DLOG_MSG_SENT, &len, sizeof(len));
+#else
         ESP_LOGI(SPP_TAG, "Message sent: %s", message);
+#endif
     } else {
         ESP_LOGW(SPP_TAG, "No active connection to send message.");
     }
@@ -123,30 +177,30 @@ static void esp_spp_cb(esp_spp_cb_event_t event, esp_spp_cb_param_t *param)
     case ESP_SPP_CL_INIT_EVT:
         ESP_LOGI(SPP_TAG, "ESP_SPP_CL_INIT_EVT");
         break;
-    case ESP_SPP_DATA_IND_EVT:
-#if (SPP_SHOW_MODE == SPP_SHOW_DATA)
-        
+    case ESP_SPP_DATA_IND_EVT: {
 /*
-* Mostramos aqui apenas os dados cujo comprimento é menor que 128. Se você quiser imprimir os dados e
-* a taxa de dados for alta, é altamente recomendável processá-los em outra tarefa de aplicativo de menor prioridade
-* em vez de processá-los diretamente neste retorno de chamada. Como a impressão leva muito tempo, ela pode travar a pilha Bluetooth
-* e também afetar a taxa de transferência de dados.
+* Este callback roda na tarefa da pilha Bluetooth: aqui apenas copiamos os dados para o buffer
+* (custo O(len), sem bloquear) e registramos o tempo gasto. A interpretação é feita em spp_cmd_task.
 */
-        ESP_LOGI(SPP_TAG, "ESP_SPP_DATA_IND_EVT len:%d handle:%"PRIu32,
-                 param->data_ind.len, param->data_ind.handle);
-        if (param->data_ind.len < 128) {
-            // esp_log_buffer_hex("", param->data_ind.data, param->data_ind.len);
-            ESP_LOGI(SPP_TAG, "ESP_SPP_DATA: %s",
-                param->data_ind.data);
+        int64_t t_start = esp_timer_get_time();
+        size_t sent = xStreamBufferSend(spp_rx_stream, param->data_ind.data, param->data_ind.len, 0);
+        uint32_t level = (uint32_t)xStreamBufferBytesAvailable(spp_rx_stream);
+        uint32_t elapsed = (uint32_t)(esp_timer_get_time() - t_start);
+        taskENTER_CRITICAL(&rx_stats_lock);
+        if (sent < param->data_ind.len) {
+            rx_stats.dropped += param->data_ind.len - sent;
         }
-#else
-        gettimeofday(&time_new, NULL);
-        data_num += param->data_ind.len;
-        if (time_new.tv_sec - time_old.tv_sec >= 3) {
-            print_speed();
+        if (level > rx_stats.level_max) {
+            rx_stats.level_max = level;
         }
-#endif
+        if (elapsed > rx_stats.cb_time_max) {
+            rx_stats.cb_time_max = elapsed;
+        }
+        rx_stats.cb_time_total += elapsed;
+        rx_stats.cb_count++;
+        taskEXIT_CRITICAL(&rx_stats_lock);
         break;
+    }
     case ESP_SPP_CONG_EVT:
         ESP_LOGI(SPP_TAG, "ESP_SPP_CONG_EVT");
         break;
@@ -173,6 +227,82 @@ static void esp_spp_cb(esp_spp_cb_event_t event, esp_spp_cb_param_t *param)
     }
 }
 
+/*
+Responde ao celular com o resultado de um comando recebido via SPP.
+*/
+static void spp_reply(cmd_result_e rv, uint32_t rate_ms)
+{
+    char reply[96];
+
+    switch (rv) {
+    case CMD_RATE_SET:
+        snprintf(reply, sizeof(reply), "\n>> Intervalo definido em %"PRIu32" ms.\n", rate_ms);
+        break;
+    case CMD_STOPPED:
+        snprintf(reply, sizeof(reply), "\n>> Medicoes paradas. Envie o intervalo (%d a %d ms).\n",
+                 MIN_REFRESH_RATE, MAX_REFRESH_RATE);
+        break;
+    case CMD_OUT_OF_RANGE:
+        snprintf(reply, sizeof(reply), "\n>> Valor fora do intervalo (%d a %d ms).\n",
+                 MIN_REFRESH_RATE, MAX_REFRESH_RATE);
+        break;
+    case CMD_UNKNOWN:
+        snprintf(reply, sizeof(reply), "\n>> Comando desconhecido. Use 'X' ou um numero.\n");
+        break;
+    default:
+        return;
+    }
+    send_message(reply);
+}
+
+/*
+Tarefa que consome os dados recebidos via SPP, monta as linhas e executa os comandos
+(mesmo conjunto do console: 'X' ou o intervalo em ms).
+*/
+static void spp_cmd_task(void *arg)
+{
+    uint8_t chunk[SPP_RX_CHUNK_SIZE];
+    char line[SPP_CMD_LINE_SIZE];
+    size_t line_len = 0;
+    bool overflow = false;
+
+    while (1) {
+        size_t len = xStreamBufferReceive(spp_rx_stream, chunk, sizeof(chunk), pdMS_TO_TICKS(SPP_STATS_PERIOD_S * 1000));
+
+#if (SPP_SHOW_MODE == SPP_SHOW_DATA)
+        if (len > 0) {
+            ESP_LOGI(SPP_TAG, "ESP_SPP_DATA len:%d", (int)len);
+            ESP_LOG_BUFFER_HEX(SPP_TAG, chunk, len);
+        }
+#else
+        gettimeofday(&time_new, NULL);
+        data_num += len;
+        if (data_num > 0 && time_new.tv_sec - time_old.tv_sec >= SPP_STATS_PERIOD_S) {
+            print_speed();
+        }
+#endif
+
+        for (size_t i = 0; i < len; i++) {
+            char c = (char)chunk[i];
+            if (c == '\r' || c == '\n') {
+                if (overflow) {
+                    spp_reply(CMD_UNKNOWN, 0);
+                } else if (line_len > 0) {
+                    uint32_t rate_ms = 0;
+                    line[line_len] = '\0';
+                    spp_reply(cmd_execute(line, &rate_ms), rate_ms);
+                }
+                line_len = 0;
+                overflow = false;
+            } else if (line_len < sizeof(line) - 1) {
+                line[line_len++] = c;
+            } else {
+                overflow = true; // Linha longa demais: descarta até o próximo fim de linha
+            }
+        }
+    }
+}
+
 void esp_bt_gap_cb(esp_bt_gap_cb_event_t event, esp_bt_gap_cb_param_t *param)
 {
     char bda_str[18] = {0};
@@ -229,6 +359,9 @@ void esp_bt_gap_cb(esp_bt_gap_cb_event_t event, esp_bt_gap_cb_param_t *param)
 void bt_init(void)
 {
     char bda_str[18] = {0};
+#if CONFIG_ZPHS01B_DEFERRED_LOG
+    dlog_register(DLOG_MSG_SENT, expand_msg_sent);
+#endif
     esp_err_t ret = nvs_flash_init();
     if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
         ESP_ERROR_CHECK(nvs_flash_erase());
@@ -264,6 +397,16 @@ void bt_init(void)
         return;
     }
 
+    spp_rx_stream = xStreamBufferCreate(SPP_RX_BUFFER_SIZE, 1);
+    if (spp_rx_stream == NULL) {
+        ESP_LOGE(SPP_TAG, "%s spp rx buffer create failed\n", __func__);
+        return;
+    }
+    if (xTaskCreate(spp_cmd_task, "spp_cmd_task", SPP_CMD_TASK_STACK_SIZE, NULL, SPP_CMD_TASK_PRIORITY, NULL) != pdPASS) {
+        ESP_LOGE(SPP_TAG, "%s spp cmd task create failed\n", __func__);
+        return;
+    }
+
     if ((ret = esp_spp_register_callback(esp_spp_cb)) != ESP_OK) {
         ESP_LOGE(SPP_TAG, "%s spp register failed: %s\n", __func__, esp_err_to_name(ret));
         return;
@@ -0,0 +1,37 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include "esp_log.h"
+
+#include "bt.h"
+
+// Transporte Bluetooth simulado para o alvo linux: as mensagens vão para a saída padrão.
+// Com ZPHS01B_BT_QUIET definido, elas são apenas contadas.
+
+#define SPP_TAG "SPP_STUB"
+
+static bool quiet = false;
+static unsigned long messages_sent = 0;
+static unsigned long bytes_sent = 0;
+
+void bt_init(void)
+{
+    quiet = getenv("ZPHS01B_BT_QUIET") != NULL;
+    ESP_LOGI(SPP_TAG, "Transporte SPP simulado (saida %s).", quiet ? "descartada" : "stdout");
+}
+
+void send_message(const char *message)
+{
+    if (message == NULL) {
+        return;
+    }
+    size_t len = strlen(message);
+    messages_sent++;
+    bytes_sent += len;
+    if (!quiet) {
+        fwrite(message, 1, len, stdout);
+        fflush(stdout);
+    }
+    ESP_LOGD(SPP_TAG, "Message %lu sent (%zu bytes, %lu total)", messages_sent, len, bytes_sent);
+}
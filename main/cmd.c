@@ -0,0 +1,69 @@
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include <inttypes.h>
+#include "esp_log.h"
+
+#include "cmd.h"
+#include "zphs01b.h"
+
+// Tamanho máximo de um comando (dígitos do intervalo ou 'X')
+#define CMD_MAX_LEN 16
+
+static const char *TAG_CMD = "CMD";
+
+cmd_result_e cmd_parse_refresh_rate(const char *text, uint32_t *rate_ms) {
+    uint32_t value = 0;
+    int digits = 0;
+
+    if (text == NULL || text[0] == '\0') return CMD_EMPTY;
+    for (const char *p = text; *p != '\0'; p++) {
+        if (*p < '0' || *p > '9') return CMD_UNKNOWN;
+        // Evita overflow: qualquer valor com mais de 5 dígitos já está fora do intervalo
+        if (++digits > 5) return CMD_OUT_OF_RANGE;
+        value = value * 10 + (uint32_t)(*p - '0');
+    }
+    if (value < MIN_REFRESH_RATE || value > MAX_REFRESH_RATE) return CMD_OUT_OF_RANGE;
+
+    if (rate_ms != NULL) *rate_ms = value;
+    return CMD_RATE_SET;
+}
+
+cmd_result_e cmd_execute(const char *line, uint32_t *rate_ms) {
+    char cmd[CMD_MAX_LEN];
+    size_t len = 0;
+    uint32_t rate = 0;
+
+    if (line == NULL) return CMD_EMPTY;
+
+    // Remove espaços e fim de linha das extremidades
+    while (*line != '\0' && isspace((unsigned char)*line)) line++;
+    while (*line != '\0' && !isspace((unsigned char)*line)) {
+        if (len >= sizeof(cmd) - 1) return CMD_UNKNOWN;
+        cmd[len++] = *line++;
+    }
+    cmd[len] = '\0';
+    while (*line != '\0' && isspace((unsigned char)*line)) line++;
+    if (*line != '\0') return CMD_UNKNOWN; // Mais de uma palavra
+
+    if (len == 0) return CMD_EMPTY;
+
+    if (len == 1 && (cmd[0] == 'X' || cmd[0] == 'x')) {
+        struct zphs01b_stats st;
+        stop_zphs01b_task();
+        ESP_LOGI(TAG_CMD, "Tarefa do sensor parada por comando.");
+        // Ciclos de CPU por leitura válida (decodificação, classificação e formatação) com os canais compilados
+        zphs01b_get_stats(&st);
+        ESP_LOGI(TAG_CMD, "%d canais, ciclos por leitura min=%" PRIu32 " media=%" PRIu64 " max=%" PRIu32 " (%" PRIu32 " leituras validas).",
+                 ZPHS01B_CH_COUNT, st.cycles_min, st.valid ? st.cycles_total / st.valid : 0, st.cycles_max, st.valid);
+        return CMD_STOPPED;
+    }
+
+    cmd_result_e rv = cmd_parse_refresh_rate(cmd, &rate);
+    if (rv == CMD_RATE_SET) {
+        init_and_run_zphs01b(rate);
+        ESP_LOGI(TAG_CMD, "Intervalo alterado por comando para %" PRIu32 " ms.", rate);
+        if (rate_ms != NULL) *rate_ms = rate;
+    }
+    return rv;
+}
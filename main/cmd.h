@@ -0,0 +1,39 @@
+#ifndef CMD_H
+#define CMD_H
+
+#include <stdint.h>
+
+// Limites do intervalo de medição, compartilhados pelo console e pelo Bluetooth
+#define DEFAULT_REFRESH_RATE 5000
+#define MIN_REFRESH_RATE     1500
+#define MAX_REFRESH_RATE     29000
+
+// Resultado da interpretação de um comando
+typedef enum {
+    CMD_RATE_SET = 0,   // Intervalo válido recebido, tarefa do sensor (re)iniciada
+    CMD_STOPPED,        // 'X' recebido, tarefa do sensor parada
+    CMD_EMPTY,          // Linha vazia, nada a fazer
+    CMD_OUT_OF_RANGE,   // Número fora de [MIN_REFRESH_RATE, MAX_REFRESH_RATE]
+    CMD_UNKNOWN         // Texto que não corresponde a nenhum comando
+} cmd_result_e;
+
+/**
+ * @brief Converte uma string de dígitos em intervalo de medição.
+ * @param text String terminada em zero (apenas dígitos).
+ * @param rate_ms Recebe o intervalo validado.
+ * @return CMD_RATE_SET, CMD_EMPTY, CMD_OUT_OF_RANGE ou CMD_UNKNOWN.
+ */
+cmd_result_e cmd_parse_refresh_rate(const char *text, uint32_t *rate_ms);
+
+/**
+ * @brief Interpreta e executa uma linha de comando (mesmo conjunto do console).
+ * "X"/"x" para a tarefa do sensor e registra no log os ciclos por leitura; um número define o intervalo e reinicia a tarefa.
+ * Espaços e '\r'/'\n' no início e no fim são ignorados. Parar ou reiniciar a tarefa espera
+ * ela terminar o ciclo de leitura em andamento (ver stop_zphs01b_task), então a chamada pode
+ * bloquear por até um ciclo; a tarefa nunca é apagada no meio de um envio por SPP.
+ * @param line String terminada em zero.
+ * @param rate_ms Recebe o intervalo aplicado quando o resultado é CMD_RATE_SET (pode ser NULL).
+ */
+cmd_result_e cmd_execute(const char *line, uint32_t *rate_ms);
+
+#endif /* CMD_H */
@@ -0,0 +1,142 @@
+#include <string.h>
+#include <stdatomic.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "sdkconfig.h"
+
+#include "dlog.h"
+#include "port.h"
+
+#ifndef CONFIG_ZPHS01B_DLOG_SLOTS
+#define CONFIG_ZPHS01B_DLOG_SLOTS 16
+#endif
+
+#define DLOG_SLOTS           CONFIG_ZPHS01B_DLOG_SLOTS
+#define DLOG_TASK_STACK_SIZE 3072
+#define DLOG_TASK_PRIORITY   (1)  // Abaixo das tarefas do sensor (10) e de comandos SPP (5)
+#define DLOG_DRAIN_PERIOD_MS 50
+
+_Static_assert((DLOG_SLOTS & (DLOG_SLOTS - 1)) == 0, "CONFIG_ZPHS01B_DLOG_SLOTS deve ser potencia de 2");
+
+static const char *TAG_DLOG = "DLOG";
+
+// Anel limitado com vários produtores e um consumidor. Cada posição tem um número de
+// sequência: igual à posição de escrita quando livre, posição + 1 quando preenchida.
+// Um produtor reserva a posição com compare-and-swap, copia os argumentos e publica a
+// sequência; o consumidor só lê posições publicadas. Nenhum lado bloqueia o outro.
+// Uma tarefa apagada (vTaskDelete) entre a reserva e a publicação deixaria a posição sem
+// publicar e o consumidor parado nela; por isso os produtores só saem fora de dlog_write
+// (a tarefa do sensor é parada de forma cooperativa, ver stop_zphs01b_task).
+struct dlog_slot {
+    atomic_uint seq;
+    uint16_t fmt;
+    uint16_t len;
+    uint32_t t_us;          // port_time_us() na gravação (truncado), para medir o atraso
+    uint8_t args[DLOG_ARGS_MAX] __attribute__((aligned(8)));
+};
+
+static struct dlog_slot ring[DLOG_SLOTS];
+static atomic_uint write_pos;   // Também é o total de registros gravados
+static unsigned int read_pos;   // Apenas a tarefa de log usa
+static atomic_uint dropped;
+static uint32_t expanded;
+static uint32_t delay_max_us;
+static dlog_expand_fn expanders[DLOG_FMT_COUNT];
+
+/**
+ * @brief Expande o próximo registro publicado, se houver.
+ * @return 1 se um registro foi expandido, 0 se o anel está vazio.
+ */
+static int dlog_drain_one(void) {
+    struct dlog_slot *slot = &ring[read_pos & (DLOG_SLOTS - 1)];
+    if (atomic_load_explicit(&slot->seq, memory_order_acquire) != read_pos + 1) return 0;
+
+    uint32_t delay = (uint32_t)port_time_us() - slot->t_us;
+    if (delay > delay_max_us) delay_max_us = delay;
+    if (slot->fmt < DLOG_FMT_COUNT && expanders[slot->fmt] != NULL) {
+        expanders[slot->fmt](slot->args, slot->len);
+    }
+    expanded++;
+
+    // Libera a posição para a próxima volta do anel
+    atomic_store_explicit(&slot->seq, read_pos + DLOG_SLOTS, memory_order_release);
+    read_pos++;
+    return 1;
+}
+
+/**
+ * @brief Tarefa de baixa prioridade que esvazia o anel periodicamente.
+ */
+static void dlog_task(void *arg) {
+    uint32_t dropped_reported = 0;
+    while (1) {
+        while (dlog_drain_one()) {
+        }
+        uint32_t d = atomic_load_explicit(&dropped, memory_order_relaxed);
+        if (d != dropped_reported) {
+            ESP_LOGW(TAG_DLOG, "%lu registros de log descartados (anel cheio).", (unsigned long)(d - dropped_reported));
+            dropped_reported = d;
+        }
+        vTaskDelay(pdMS_TO_TICKS(DLOG_DRAIN_PERIOD_MS));
+    }
+}
+
+void dlog_init(void) {
+    for (unsigned int i = 0; i < DLOG_SLOTS; i++) {
+        atomic_init(&ring[i].seq, i);
+    }
+#if CONFIG_ZPHS01B_DEFERRED_LOG
+    if (xTaskCreate(dlog_task, "dlog_task", DLOG_TASK_STACK_SIZE, NULL, DLOG_TASK_PRIORITY, NULL) != pdPASS) {
+        ESP_LOGE(TAG_DLOG, "Erro ao criar a tarefa de log adiado.");
+        return;
+    }
+    ESP_LOGI(TAG_DLOG, "Log adiado ativo (%d registros).", DLOG_SLOTS);
+#endif
+}
+
+void dlog_register(dlog_fmt_e fmt, dlog_expand_fn fn) {
+    if (fmt < DLOG_FMT_COUNT) expanders[fmt] = fn;
+}
+
+bool dlog_write(dlog_fmt_e fmt, const void *args, size_t len) {
+    if (len > DLOG_ARGS_MAX) return false;
+
+    unsigned int pos = atomic_load_explicit(&write_pos, memory_order_relaxed);
+    struct dlog_slot *slot;
+    while (1) {
+        slot = &ring[pos & (DLOG_SLOTS - 1)];
+        int diff = (int)(atomic_load_explicit(&slot->seq, memory_order_acquire) - pos);
+        if (diff == 0) {
+            // Posição livre: tenta reservá-la (em caso de falha, pos recebe a posição atual)
+            if (atomic_compare_exchange_weak_explicit(&write_pos, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            // O consumidor ainda não liberou esta posição: anel cheio
+            atomic_fetch_add_explicit(&dropped, 1, memory_order_relaxed);
+            return false;
+        } else {
+            // Outro produtor reservou esta posição; tenta a seguinte
+            pos = atomic_load_explicit(&write_pos, memory_order_relaxed);
+        }
+    }
+
+    slot->fmt = (uint16_t)fmt;
+    slot->len = (uint16_t)len;
+    slot->t_us = (uint32_t)port_time_us();
+    memcpy(slot->args, args, len);
+    atomic_store_explicit(&slot->seq, pos + 1, memory_order_release);
+    return true;
+}
+
+void dlog_get_stats(struct dlog_stats *out) {
+    if (out == NULL) return;
+    // write_pos conta só os registros gravados; written inclui também os descartados
+    uint32_t d = atomic_load_explicit(&dropped, memory_order_relaxed);
+    out->written = atomic_load_explicit(&write_pos, memory_order_relaxed) + d;
+    out->dropped = d;
+    out->expanded = expanded;
+    out->delay_max_us = delay_max_us;
+}
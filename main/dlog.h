@@ -0,0 +1,63 @@
+#ifndef DLOG_H
+#define DLOG_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+// Log adiado: os pontos de log do caminho crítico (um por leitura do sensor) gravam apenas
+// um identificador de formato e os argumentos brutos em um anel sem travas. Uma tarefa de
+// baixa prioridade expande os registros depois, fora da tarefa do sensor, chamando a função
+// registrada para cada formato (que normalmente formata o texto e chama ESP_LOGx).
+
+// Tamanho máximo dos argumentos brutos de um registro
+#define DLOG_ARGS_MAX 112
+
+// Identificadores de formato
+typedef enum {
+    DLOG_OUTPUT_MSG = 0,    // struct air_data de uma leitura válida (zphs01b.c)
+    DLOG_MSG_SENT,          // tamanho de uma mensagem enviada por SPP (bt.c)
+    DLOG_FMT_COUNT
+} dlog_fmt_e;
+
+/**
+ * @brief Expande um registro. Roda na tarefa de log, nunca na tarefa que o gravou.
+ * @param args Cópia dos argumentos passados a dlog_write.
+ * @param len Tamanho dos argumentos.
+ */
+typedef void (*dlog_expand_fn)(const void *args, size_t len);
+
+/**
+ * @brief Contadores do log adiado.
+ */
+struct dlog_stats {
+    uint32_t written;       // Chamadas a dlog_write (registros gravados + descartados)
+    uint32_t dropped;       // Registros descartados com o anel cheio
+    uint32_t expanded;      // Registros já expandidos pela tarefa de log
+    uint32_t delay_max_us;  // Maior atraso entre a gravação e a expansão
+};
+
+/**
+ * @brief Prepara o anel e cria a tarefa de log. Chamar apenas uma vez, antes dos demais módulos.
+ */
+void dlog_init(void);
+
+/**
+ * @brief Associa a função de expansão a um formato.
+ */
+void dlog_register(dlog_fmt_e fmt, dlog_expand_fn fn);
+
+/**
+ * @brief Grava um registro sem bloquear (pode ser chamada por várias tarefas ao mesmo tempo).
+ * Com o anel cheio o registro é descartado e contado. A tarefa que chama não pode ser apagada
+ * com vTaskDelete enquanto estiver dentro desta função.
+ * @return true se o registro foi gravado.
+ */
+bool dlog_write(dlog_fmt_e fmt, const void *args, size_t len);
+
+/**
+ * @brief Copia os contadores do log adiado.
+ */
+void dlog_get_stats(struct dlog_stats *out);
+
+#endif /* DLOG_H */
@@ -1,17 +1,21 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <inttypes.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "driver/uart.h"
 #include "esp_log.h"
+#include "sdkconfig.h"
 
 #include "bt.h"
+#include "cmd.h"
+#include "dlog.h"
+#include "port.h"
 #include "zphs01b.h"
+#if CONFIG_IDF_TARGET_LINUX
+#include "soak.h"
+#endif
 
-#define DEFAULT_REFRESH_RATE 5000
-#define MIN_REFRESH_RATE     1500
-#define MAX_REFRESH_RATE     29000
 #define INPUT_TIMEOUT_S      180
 #define STARTUP_DELAY_S      10
 
@@ -24,7 +28,7 @@ static int read_user_input_with_echo(char *buffer, int max_len, int timeout_ms)
     TickType_t start_ticks = xTaskGetTickCount();
     memset(buffer, 0, max_len);
     while ((xTaskGetTickCount() - start_ticks) * portTICK_PERIOD_MS < timeout_ms) {
-        if (uart_read_bytes(UART_NUM_0, (uint8_t *)&c, 1, pdMS_TO_TICKS(20)) > 0) {
+        if (port_console_read_char(&c, 20)) {
             if (c == '\r' || c == '\n') { printf("\n"); fflush(stdout); return len; }
             if ((c == '\b' || c == 127) && len > 0) { len--; printf("\b \b"); fflush(stdout); }
             else if (c >= '0' && c <= '9' && len < max_len - 1) { buffer[len++] = c; printf("%c", c); fflush(stdout); }
@@ -47,20 +51,28 @@ uint32_t get_frequency_from_user(void) {
 
     int length = read_user_input_with_echo(input_buffer, sizeof(input_buffer), INPUT_TIMEOUT_S * 1000);
 
+    // Intervalo definido via Bluetooth enquanto o console esperava: tem precedência sobre o padrão
+    uint32_t spp_rate = zphs01b_get_rate();
+
     if (length > 0) {
-        int input_val = atoi(input_buffer);
-        if (input_val >= MIN_REFRESH_RATE && input_val <= MAX_REFRESH_RATE) {
-            refresh_rate = (uint32_t)input_val;
+        // Mesma validação usada para os comandos recebidos via Bluetooth
+        if (cmd_parse_refresh_rate(input_buffer, &refresh_rate) == CMD_RATE_SET) {
             ESP_LOGI(TAG_MAIN, "Valor valido recebido.");
+        } else if (spp_rate != 0) {
+            ESP_LOGW(TAG_MAIN, "Valor '%s' e invalido ou fora do intervalo. Mantendo o intervalo definido via Bluetooth.", input_buffer);
+            refresh_rate = spp_rate;
         } else {
             ESP_LOGW(TAG_MAIN, "Valor '%s' e invalido ou fora do intervalo. Usando o valor padrao.", input_buffer);
             refresh_rate = DEFAULT_REFRESH_RATE;
         }
+    } else if (spp_rate != 0) {
+        ESP_LOGI(TAG_MAIN, "Nenhum dado inserido (timeout). Mantendo o intervalo definido via Bluetooth.");
+        refresh_rate = spp_rate;
     } else {
         ESP_LOGI(TAG_MAIN, "Nenhum dado inserido (timeout). Usando o valor padrao.");
     }
 
-    printf("\nVoce definiu o tempo de recebimento em %lu ms.\n", refresh_rate);
+    printf("\nVoce definiu o tempo de recebimento em %" PRIu32 " ms.\n", refresh_rate);
     printf("------------------------------------------------------------------\n\n");
     vTaskDelay(pdMS_TO_TICKS(1000)); // Pequena pausa antes de iniciar o sensor
     return refresh_rate;
@@ -70,7 +82,17 @@ uint32_t get_frequency_from_user(void) {
 void app_main(void)
 {
     // Inicializa a UART do console para entrada do usuário
-    uart_driver_install(UART_NUM_0, 256, 0, 0, NULL, 0);
+    port_console_init();
+
+#if CONFIG_IDF_TARGET_LINUX
+    // No host, ZPHS01B_SOAK_SECONDS dispara um teste de resistência contra o emulador e encerra o processo
+    if (soak_requested()) {
+        dlog_init();
+        zphs01b_uart_init();
+        bt_init();
+        soak_run();
+    }
+#endif
 
     printf("Iniciando em %d segundos...\n", STARTUP_DELAY_S);
     vTaskDelay(pdMS_TO_TICKS(STARTUP_DELAY_S * 1000));
@@ -87,19 +109,26 @@ void app_main(void)
     printf("se estabilizem. Recomenda-se utilizar os dados para tratamento real somente\n");
     printf("apos este periodo.\n\n");
 
-    // Inicializa o bluetooth e a UART do sensor 
+    // Inicializa o log adiado (antes dos módulos que gravam nele), o bluetooth e a UART do sensor
+    dlog_init();
     zphs01b_uart_init(); // <-- chamada da nova função de inicializaçã do sensor
+#if CONFIG_EXAMPLE_BT_SPP_AT_BOOT
+    bt_init();           // Comandos recebidos via SPP são tratados por uma tarefa própria do bt.c
+#endif
 
     // Loop principal do programa
     while (1) {
         uint32_t current_frequency = get_frequency_from_user();
-        init_and_run_zphs01b(current_frequency);
+        // Não reinicia a tarefa se ela já roda com esse intervalo (ex.: definido via Bluetooth)
+        if (zphs01b_get_rate() != current_frequency) {
+            init_and_run_zphs01b(current_frequency);
+        }
 
         // Loop de monitoramento: se mantém enquanto o sensor roda
         while (1) {
             char c;
             // Verifica se o usuário digitou algo, sem bloquear
-            if (uart_read_bytes(UART_NUM_0, (uint8_t *)&c, 1, pdMS_TO_TICKS(100)) > 0) {
+            if (port_console_read_char(&c, 100)) {
                 if (c == 'X' || c == 'x') {
                     printf("\n>> Solicitacao para alterar frequencia recebida! <<\n");
                     stop_zphs01b_task(); // Para a tarefa do sensor
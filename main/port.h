@@ -0,0 +1,61 @@
+#ifndef PORT_H
+#define PORT_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Camada de portabilidade: E/S do sensor e do console, tempo e memória.
+// port_esp32.c usa os drivers UART do ESP-IDF; port_linux.c permite rodar a
+// aplicação no alvo "linux" do ESP-IDF, falando com o emulador via pseudo-terminal.
+
+/**
+ * @brief Inicializa a interface serial com o sensor. Chamar apenas uma vez.
+ */
+void port_sensor_init(void);
+
+/**
+ * @brief Envia bytes para o sensor.
+ * @return Quantidade de bytes escritos ou -1 em caso de erro.
+ */
+int port_sensor_write(const uint8_t *data, size_t len);
+
+/**
+ * @brief Lê até len bytes do sensor, esperando no máximo timeout_ms.
+ * Retorna assim que len bytes forem recebidos.
+ * @return Quantidade de bytes lidos (0 em timeout) ou -1 em caso de erro.
+ */
+int port_sensor_read(uint8_t *buf, size_t len, uint32_t timeout_ms);
+
+/**
+ * @brief Descarta bytes pendentes (respostas atrasadas, ruído) na entrada do sensor.
+ */
+void port_sensor_flush(void);
+
+/**
+ * @brief Inicializa a entrada do console do usuário.
+ */
+void port_console_init(void);
+
+/**
+ * @brief Lê um caractere do console.
+ * @return 1 se um caractere foi lido, 0 em timeout.
+ */
+int port_console_read_char(char *c, uint32_t timeout_ms);
+
+/**
+ * @brief Tempo monotônico em microssegundos.
+ */
+int64_t port_time_us(void);
+
+/**
+ * @brief Contador de ciclos da CPU (no host, do TSC ou nanossegundos), para medir trechos curtos.
+ * O contador dá a volta; use apenas a diferença entre duas leituras.
+ */
+uint32_t port_cycle_count(void);
+
+/**
+ * @brief Bytes atualmente alocados no heap (para acompanhar vazamentos).
+ */
+size_t port_heap_used(void);
+
+#endif /* PORT_H */
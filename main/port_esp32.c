@@ -0,0 +1,75 @@
+#include "freertos/FreeRTOS.h"
+#include "driver/uart.h"
+#include "driver/gpio.h"
+#include "esp_heap_caps.h"
+#include "esp_cpu.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "sdkconfig.h"
+
+#include "port.h"
+
+// Pinos para a comunicação UART com o sensor, vindos da configuração do projeto (menuconfig)
+#define UART_TXD_PIN (CONFIG_EXAMPLE_UART_TXD)
+#define UART_RXD_PIN (CONFIG_EXAMPLE_UART_RXD)
+#define UART_RTS (UART_PIN_NO_CHANGE)
+#define UART_CTS (UART_PIN_NO_CHANGE)
+// Configurações da porta UART
+#define UART_PORT_NUM      (CONFIG_EXAMPLE_UART_PORT_NUM)
+#define UART_BAUD_RATE     (CONFIG_EXAMPLE_UART_BAUD_RATE)
+// Tamanho do buffer de recepção do driver UART
+#define UART_RX_BUF_SIZE   (2048)
+// Porta e buffer do console do usuário
+#define CONSOLE_PORT_NUM   (UART_NUM_0)
+#define CONSOLE_BUF_SIZE   (256)
+
+static const char *TAG_PORT = "PORT";
+
+void port_sensor_init(void) {
+    // Estrutura de configuração da UART
+    uart_config_t uart_config = {
+        .baud_rate = UART_BAUD_RATE,
+        .data_bits = UART_DATA_8_BITS,
+        .parity    = UART_PARITY_DISABLE,
+        .stop_bits = UART_STOP_BITS_1,
+        .flow_ctrl = UART_HW_FLOWCTRL_DISABLE,
+        .source_clk = UART_SCLK_DEFAULT,
+    };
+    // Instala e configura o driver UART com os pinos definidos
+    ESP_ERROR_CHECK(uart_driver_install(UART_PORT_NUM, UART_RX_BUF_SIZE, 0, 0, NULL, 0));
+    ESP_ERROR_CHECK(uart_param_config(UART_PORT_NUM, &uart_config));
+    ESP_ERROR_CHECK(uart_set_pin(UART_PORT_NUM, UART_TXD_PIN, UART_RXD_PIN, UART_RTS, UART_CTS));
+    ESP_LOGI(TAG_PORT, "UART %d do sensor configurada.", UART_PORT_NUM);
+}
+
+int port_sensor_write(const uint8_t *data, size_t len) {
+    return uart_write_bytes(UART_PORT_NUM, data, len);
+}
+
+int port_sensor_read(uint8_t *buf, size_t len, uint32_t timeout_ms) {
+    return uart_read_bytes(UART_PORT_NUM, buf, len, pdMS_TO_TICKS(timeout_ms));
+}
+
+void port_sensor_flush(void) {
+    uart_flush_input(UART_PORT_NUM);
+}
+
+void port_console_init(void) {
+    uart_driver_install(CONSOLE_PORT_NUM, CONSOLE_BUF_SIZE, 0, 0, NULL, 0);
+}
+
+int port_console_read_char(char *c, uint32_t timeout_ms) {
+    return uart_read_bytes(CONSOLE_PORT_NUM, (uint8_t *)c, 1, pdMS_TO_TICKS(timeout_ms)) > 0;
+}
+
+int64_t port_time_us(void) {
+    return esp_timer_get_time();
+}
+
+uint32_t port_cycle_count(void) {
+    return (uint32_t)esp_cpu_get_cycle_count();
+}
+
+size_t port_heap_used(void) {
+    return heap_caps_get_total_size(MALLOC_CAP_DEFAULT) - heap_caps_get_free_size(MALLOC_CAP_DEFAULT);
+}
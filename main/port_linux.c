@@ -0,0 +1,133 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <malloc.h>
+#include <poll.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include "esp_log.h"
+#include "sdkconfig.h"
+
+#include "port.h"
+
+// Pseudo-terminal do emulador do sensor; pode ser sobrescrito pela variável de ambiente ZPHS01B_PTY
+#define SENSOR_PTY_PATH (CONFIG_EXAMPLE_SENSOR_PTY_PATH)
+
+static const char *TAG_PORT = "PORT";
+static int sensor_fd = -1;
+// Fator de aceleração dos timeouts do sensor (ZPHS01B_TIME_SCALE), igual ao --speed do emulador
+static double time_scale = 1.0;
+static int console_eof = 0;
+
+// Espera até o descritor ter dados para ler, repetindo se interrompido pelo tick do FreeRTOS
+static int wait_readable(int fd, int timeout_ms) {
+    struct pollfd pfd = {.fd = fd, .events = POLLIN};
+    int64_t deadline = port_time_us() + (int64_t)timeout_ms * 1000;
+    while (1) {
+        int remaining_ms = (int)((deadline - port_time_us() + 999) / 1000);
+        if (remaining_ms < 0) remaining_ms = 0;
+        int rv = poll(&pfd, 1, remaining_ms);
+        if (rv >= 0) return rv;
+        if (errno != EINTR) return -1;
+    }
+}
+
+void port_sensor_init(void) {
+    const char *path = getenv("ZPHS01B_PTY");
+    if (path == NULL) path = SENSOR_PTY_PATH;
+
+    sensor_fd = open(path, O_RDWR | O_NOCTTY);
+    if (sensor_fd < 0) {
+        ESP_LOGE(TAG_PORT, "Nao foi possivel abrir %s (o emulador esta rodando?)", path);
+        abort();
+    }
+    // Modo bruto: sem eco, sem tradução de fim de linha
+    struct termios tio;
+    if (tcgetattr(sensor_fd, &tio) == 0) {
+        cfmakeraw(&tio);
+        tcsetattr(sensor_fd, TCSANOW, &tio);
+    }
+    const char *scale = getenv("ZPHS01B_TIME_SCALE");
+    if (scale != NULL && atof(scale) > 0) time_scale = atof(scale);
+    ESP_LOGI(TAG_PORT, "Sensor emulado em %s (tempo %.1fx).", path, time_scale);
+}
+
+int port_sensor_write(const uint8_t *data, size_t len) {
+    size_t done = 0;
+    while (done < len) {
+        ssize_t n = write(sensor_fd, data + done, len - done);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        done += (size_t)n;
+    }
+    return (int)done;
+}
+
+int port_sensor_read(uint8_t *buf, size_t len, uint32_t timeout_ms) {
+    size_t done = 0;
+    int64_t deadline = port_time_us() + (int64_t)(timeout_ms * 1000 / time_scale);
+    while (done < len) {
+        int remaining_ms = (int)((deadline - port_time_us() + 999) / 1000);
+        if (remaining_ms <= 0) break;
+        int rv = wait_readable(sensor_fd, remaining_ms);
+        if (rv < 0) return -1;
+        if (rv == 0) break;
+        ssize_t n = read(sensor_fd, buf + done, len - done);
+        if (n < 0) {
+            if (errno == EINTR || errno == EAGAIN) continue;
+            return -1;
+        }
+        if (n == 0) break;
+        done += (size_t)n;
+    }
+    return (int)done;
+}
+
+void port_sensor_flush(void) {
+    tcflush(sensor_fd, TCIFLUSH);
+}
+
+void port_console_init(void) {
+    // Entrega cada tecla imediatamente, sem eco (o eco é feito pela aplicação)
+    if (isatty(STDIN_FILENO)) {
+        struct termios tio;
+        if (tcgetattr(STDIN_FILENO, &tio) == 0) {
+            tio.c_lflag &= ~(ICANON | ECHO);
+            tcsetattr(STDIN_FILENO, TCSANOW, &tio);
+        }
+    }
+}
+
+int port_console_read_char(char *c, uint32_t timeout_ms) {
+    // Sem entrada (stdin fechado): apenas espera, como um console sem teclas pressionadas
+    if (console_eof) { usleep(timeout_ms * 1000); return 0; }
+    if (wait_readable(STDIN_FILENO, (int)timeout_ms) <= 0) return 0;
+    ssize_t n = read(STDIN_FILENO, c, 1);
+    if (n == 0) console_eof = 1;
+    return n == 1;
+}
+
+int64_t port_time_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+uint32_t port_cycle_count(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return (uint32_t)__builtin_ia32_rdtsc();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec);
+#endif
+}
+
+size_t port_heap_used(void) {
+    struct mallinfo2 mi = mallinfo2();
+    return mi.uordblks;
+}
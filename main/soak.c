@@ -0,0 +1,149 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include <malloc.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "sdkconfig.h"
+
+#include "cmd.h"
+#include "dlog.h"
+#include "port.h"
+#include "soak.h"
+#include "zphs01b.h"
+#include "zphs01b_proto.h"
+#include "spike_filter.h"
+
+// Período de verificação do andamento do teste
+#define SOAK_POLL_MS (50)
+// Tempo máximo para a tarefa de log esvaziar o anel no fim do teste
+#define SOAK_DLOG_DRAIN_MS (2000)
+// Crescimento de heap tolerado entre a metade e o fim dos reinícios. Cobre buffers do stdio e
+// pilhas de threads que a tarefa ociosa ainda não liberou; um vazamento por reinício aparece
+// como crescimento proporcional ao número de reinícios (com 720 reinícios, ~12 bytes cada
+// já passam do limite).
+#define SOAK_HEAP_TOLERANCE (4096)
+
+static const char *TAG_SOAK = "SOAK";
+
+static uint32_t env_u32(const char *name, uint32_t def) {
+    const char *v = getenv(name);
+    return (v != NULL && v[0] != '\0') ? (uint32_t)strtoul(v, NULL, 10) : def;
+}
+
+static double env_double(const char *name, double def) {
+    const char *v = getenv(name);
+    return (v != NULL && atof(v) > 0) ? atof(v) : def;
+}
+
+// Espera até o total de respostas (válidas ou não) atingir target
+static void wait_requests(uint32_t target, struct zphs01b_stats *st) {
+    do {
+        vTaskDelay(pdMS_TO_TICKS(SOAK_POLL_MS));
+        zphs01b_get_stats(st);
+    } while (st->requests < target);
+}
+
+#if CONFIG_ZPHS01B_DEFERRED_LOG
+// Espera a tarefa de log expandir todos os registros gravados. Um registro reservado e nunca
+// publicado (produtor apagado no meio de dlog_write) trava o anel e faz esta espera falhar.
+static bool wait_dlog_drained(struct dlog_stats *ls) {
+    for (int waited = 0; ; waited += SOAK_POLL_MS) {
+        dlog_get_stats(ls);
+        if (ls->expanded == ls->written - ls->dropped) return true;
+        if (waited >= SOAK_DLOG_DRAIN_MS) return false;
+        vTaskDelay(pdMS_TO_TICKS(SOAK_POLL_MS));
+    }
+}
+#endif
+
+bool soak_requested(void) {
+    return getenv("ZPHS01B_SOAK_SECONDS") != NULL;
+}
+
+void soak_run(void) {
+    uint32_t sim_seconds = env_u32("ZPHS01B_SOAK_SECONDS", 3600);
+    uint32_t interval_ms = env_u32("ZPHS01B_SOAK_INTERVAL_MS", DEFAULT_REFRESH_RATE);
+    uint32_t restarts    = env_u32("ZPHS01B_SOAK_RESTARTS", 10);
+    double time_scale    = env_double("ZPHS01B_TIME_SCALE", 1.0);
+    if (interval_ms == 0) interval_ms = DEFAULT_REFRESH_RATE;
+    // Pausa entre leituras da tarefa do sensor: o intervalo real acelerado pelo mesmo fator do
+    // emulador, para que a aceleração medida corresponda a ZPHS01B_TIME_SCALE. 0 = sem pausa (carga máxima).
+    uint32_t pause_ms    = env_u32("ZPHS01B_SOAK_PAUSE_MS", (uint32_t)(interval_ms / time_scale));
+
+    uint32_t samples = (uint32_t)((uint64_t)sim_seconds * 1000 / interval_ms);
+    if (samples == 0) samples = 1;
+    uint32_t segment = samples / (restarts + 1);
+    if (segment == 0) segment = 1;
+
+    // As tarefas do FreeRTOS são threads; uma única arena torna o uso de heap comparável
+    mallopt(M_ARENA_MAX, 1);
+    // As mensagens por leitura atrasariam o teste; mantém apenas os erros
+    esp_log_level_set("*", ESP_LOG_ERROR);
+
+    printf("soak: %" PRIu32 " s simulados a cada %" PRIu32 " ms = %" PRIu32 " leituras, %" PRIu32 " reinicios\n",
+           sim_seconds, interval_ms, samples, restarts);
+    printf("soak: tempo %.1fx, pausa entre leituras %" PRIu32 " ms\n", time_scale, pause_ms);
+
+    struct zphs01b_stats st = {0};
+    size_t heap_warm = 0, heap_mid = 0;
+    int64_t t_start = port_time_us();
+
+    // Cada segmento reinicia a tarefa, como uma reconfiguração pelo console ou Bluetooth
+    for (uint32_t target = segment; ; target += segment) {
+        if (target > samples) target = samples;
+        init_and_run_zphs01b(pause_ms);
+        wait_requests(target, &st);
+        stop_zphs01b_task();
+        vTaskDelay(pdMS_TO_TICKS(SOAK_POLL_MS)); // Deixa a tarefa ociosa liberar a pilha da tarefa encerrada
+        // Referência de heap após o primeiro ciclo (buffers do stdio, logs etc. já alocados)
+        if (heap_warm == 0) heap_warm = port_heap_used();
+        // Referência para o teste de vazamento: metade dos reinícios já feita
+        if (heap_mid == 0 && target >= samples / 2) heap_mid = port_heap_used();
+        if (target >= samples) break;
+    }
+
+    int64_t elapsed_us = port_time_us() - t_start;
+#if CONFIG_ZPHS01B_DEFERRED_LOG
+    struct dlog_stats ls;
+    bool dlog_ok = wait_dlog_drained(&ls);
+#else
+    bool dlog_ok = true;
+#endif
+    size_t heap_end = port_heap_used();
+    double elapsed_s = elapsed_us / 1e6;
+
+    printf("soak: leituras=%" PRIu32 " validas=%" PRIu32 " invalidas=%" PRIu32 " timeouts=%" PRIu32 "\n",
+           st.requests, st.valid, st.invalid, st.timeouts);
+    printf("soak: tempo real=%.2f s, vazao=%.1f leituras/s, aceleracao=%.0fx\n",
+           elapsed_s, st.requests / elapsed_s, sim_seconds / elapsed_s);
+    printf("soak: latencia min=%" PRIu32 " us media=%" PRIu64 " us max=%" PRIu32 " us\n",
+           st.latency_min_us, st.valid ? st.latency_total_us / st.valid : 0, st.latency_max_us);
+    printf("soak: %d canais, ciclos por leitura min=%" PRIu32 " media=%" PRIu64 " max=%" PRIu32 "\n",
+           ZPHS01B_CH_COUNT, st.cycles_min, st.valid ? st.cycles_total / st.valid : 0, st.cycles_max);
+    printf("soak: ciclos do log por leitura min=%" PRIu32 " media=%" PRIu64 " max=%" PRIu32 "\n",
+           st.log_cycles_min, st.valid ? st.log_cycles_total / st.valid : 0, st.log_cycles_max);
+#if CONFIG_ZPHS01B_DEFERRED_LOG
+    printf("soak: log adiado gravados=%" PRIu32 " expandidos=%" PRIu32 " descartados=%" PRIu32 " atraso max=%" PRIu32 " us\n",
+           ls.written, ls.expanded, ls.dropped, ls.delay_max_us);
+    if (!dlog_ok) ESP_LOGE(TAG_SOAK, "Log adiado travado: expandidos != gravados - descartados.");
+#endif
+#if SPIKE_FILTER_ENABLED
+    printf("soak: filtro de picos, rejeitadas/substituidas:");
+#define SOAK_FILTER_FIELD_(id, CH, type, ofs, width, num, den, bias, has_lvl, filt, lvl_label, value_fmt) \
+    ZPHS01B_IF_##filt(printf(" " #id "=%" PRIu32 "/%" PRIu32, st.filter_rejected[ZPHS01B_CH_##CH], st.filter_replaced[ZPHS01B_CH_##CH]);)
+    ZPHS01B_CHANNEL_LIST(SOAK_FILTER_FIELD_)
+    printf("\n");
+#endif
+    printf("soak: heap apos aquecimento=%zu bytes, meio=%zu bytes, final=%zu bytes, variacao=%+ld bytes (tolerancia %d)\n",
+           heap_warm, heap_mid, heap_end, (long)heap_end - (long)heap_mid, SOAK_HEAP_TOLERANCE);
+
+    // Só a segunda metade conta: o aquecimento (buffers do stdio, primeiras pilhas) fica antes do meio
+    bool heap_ok = heap_end <= heap_mid + SOAK_HEAP_TOLERANCE;
+    bool ok = st.valid > 0 && heap_ok && dlog_ok;
+    if (!heap_ok) ESP_LOGE(TAG_SOAK, "Heap cresceu apos a metade dos reinicios: possivel vazamento.");
+    if (!ok) ESP_LOGE(TAG_SOAK, "Teste de resistencia falhou.");
+    fflush(stdout);
+    exit(ok ? 0 : 1);
+}
@@ -0,0 +1,24 @@
+#ifndef SOAK_H
+#define SOAK_H
+
+#include <stdbool.h>
+
+// Teste de resistência da aplicação no host (alvo linux), contra o emulador do ZPHS01B.
+// Configurado por variáveis de ambiente:
+//   ZPHS01B_SOAK_SECONDS     duração simulada do teste (obrigatória para ativar)
+//   ZPHS01B_SOAK_INTERVAL_MS intervalo simulado entre leituras (padrão DEFAULT_REFRESH_RATE)
+//   ZPHS01B_SOAK_PAUSE_MS    pausa real entre leituras (padrão 0, o mais rápido possível)
+//   ZPHS01B_SOAK_RESTARTS    reinícios da tarefa do sensor durante o teste (padrão 10)
+
+/**
+ * @brief Indica se o teste de resistência foi solicitado (ZPHS01B_SOAK_SECONDS definido).
+ */
+bool soak_requested(void);
+
+/**
+ * @brief Executa o teste, imprime o relatório e encerra o processo.
+ * O código de saída é 0 se houve leituras válidas e o heap não cresceu.
+ */
+void soak_run(void) __attribute__((noreturn));
+
+#endif /* SOAK_H */
@@ -0,0 +1,112 @@
+#include <string.h>
+#include <stdbool.h>
+#include <math.h>
+
+#include "spike_filter.h"
+
+#ifdef CONFIG_ZPHS01B_FILTER_HAMPEL_K10
+#define HAMPEL_K (CONFIG_ZPHS01B_FILTER_HAMPEL_K10 / 10.0f)
+#else
+#define HAMPEL_K (3.0f)
+#endif
+// Converte a MAD em estimativa do desvio padrão para ruído gaussiano
+#define MAD_SCALE (1.4826f)
+
+/**
+ * @brief Primeira posição de sorted[0..n) com valor >= v (busca binária).
+ */
+static int lower_bound(const float *sorted, int n, float v) {
+    int lo = 0, hi = n;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (sorted[mid] < v) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+/**
+ * @brief Remove de sorted[0..n) uma ocorrência de v, que deve estar presente.
+ */
+static void sorted_remove(float *sorted, int n, float v) {
+    int i = lower_bound(sorted, n, v);
+    memmove(&sorted[i], &sorted[i + 1], (size_t)(n - i - 1) * sizeof(float));
+}
+
+/**
+ * @brief Insere v em sorted[0..n), mantendo a ordem.
+ */
+static void sorted_insert(float *sorted, int n, float v) {
+    int i = lower_bound(sorted, n, v);
+    memmove(&sorted[i + 1], &sorted[i], (size_t)(n - i) * sizeof(float));
+    sorted[i] = v;
+}
+
+/**
+ * @brief MAD (mediana dos desvios absolutos em relação à mediana) de uma janela ordenada e ímpar.
+ * Os desvios à esquerda e à direita da mediana já estão em ordem crescente a partir do centro;
+ * basta intercalar as duas sequências até o elemento central, sem ordenar nada.
+ */
+static float sorted_mad(const float *sorted, int n) {
+    int m = (n - 1) / 2;
+    float med = sorted[m];
+    int left = m, right = m + 1;
+    float d = 0;
+    for (int k = 0; k <= m; k++) {
+        float dl = left >= 0 ? med - sorted[left] : INFINITY;
+        float dr = right < n ? sorted[right] - med : INFINITY;
+        if (dl <= dr) {
+            d = dl;
+            left--;
+        } else {
+            d = dr;
+            right++;
+        }
+    }
+    return d;
+}
+
+void spike_filter_init(struct spike_filter *f, float resolution) {
+    memset(f, 0, sizeof(*f));
+    f->resolution = resolution;
+}
+
+void spike_filter_reset(struct spike_filter *f) {
+    f->count = 0;
+    f->head = 0;
+}
+
+float spike_filter_apply(struct spike_filter *f, float x) {
+    if (isnan(x)) return x;
+
+    // Desliza a janela: retira a amostra mais antiga e insere a nova nas duas formas
+    if (f->count == SPIKE_FILTER_WINDOW) {
+        sorted_remove(f->sorted, f->count, f->window[f->head]);
+        f->count--;
+    }
+    f->window[f->head] = x;
+    f->head = (uint8_t)((f->head + 1) % SPIKE_FILTER_WINDOW);
+    sorted_insert(f->sorted, f->count, x);
+    f->count++;
+
+    // Com janela incompleta usa a mediana inferior das amostras disponíveis
+    float med = f->sorted[(f->count - 1) / 2];
+
+    // Teste de Hampel, nos dois modos: só decide com a janela cheia
+    bool outlier = false;
+    if (f->count == SPIKE_FILTER_WINDOW) {
+        float mad = sorted_mad(f->sorted, f->count);
+        if (mad < f->resolution) mad = f->resolution; // Sinal constante: MAD 0 rejeitaria qualquer passo
+        outlier = fabsf(x - med) > HAMPEL_K * MAD_SCALE * mad;
+    }
+    if (outlier) f->rejected++;
+
+#ifdef CONFIG_ZPHS01B_FILTER_HAMPEL
+    // Só os valores atípicos são trocados pela mediana
+    float out = outlier ? med : x;
+#else
+    float out = med;
+#endif
+    if (out != x) f->replaced++;
+    return out;
+}
@@ -0,0 +1,61 @@
+#ifndef SPIKE_FILTER_H
+#define SPIKE_FILTER_H
+
+#include <stdint.h>
+#ifdef ESP_PLATFORM
+#include "sdkconfig.h"
+#endif
+
+// Filtro de picos aplicado entre a decodificação e a classificação em níveis, nos canais
+// marcados com filt na tabela de zphs01b_proto.h (menuconfig > Spike filter). Mediana móvel:
+// a saída é a mediana das últimas SPIKE_FILTER_WINDOW amostras. Hampel: a amostra passa sem
+// alteração, a não ser que se afaste da mediana mais que k * 1.4826 * MAD; nesse caso é
+// substituída pela mediana.
+#if defined(CONFIG_ZPHS01B_FILTER_MEDIAN) || defined(CONFIG_ZPHS01B_FILTER_HAMPEL)
+#define SPIKE_FILTER_ENABLED 1
+#else
+#define SPIKE_FILTER_ENABLED 0
+#endif
+
+#ifdef CONFIG_ZPHS01B_FILTER_WINDOW
+#define SPIKE_FILTER_WINDOW CONFIG_ZPHS01B_FILTER_WINDOW
+#else
+#define SPIKE_FILTER_WINDOW 5
+#endif
+
+// Mesmo intervalo do Kconfig (3 a 15). Ímpar porque a mediana e a MAD usam o elemento central.
+_Static_assert(SPIKE_FILTER_WINDOW % 2 == 1 && SPIKE_FILTER_WINDOW >= 3 && SPIKE_FILTER_WINDOW <= 15,
+               "CONFIG_ZPHS01B_FILTER_WINDOW deve ser impar, entre 3 e 15");
+
+// Janela deslizante mantida em duas formas: na ordem de chegada (anel), para saber qual
+// amostra sai, e ordenada, para obter mediana e MAD sem reordenar a cada amostra.
+struct spike_filter {
+    float window[SPIKE_FILTER_WINDOW];  // anel, na ordem de chegada
+    float sorted[SPIKE_FILTER_WINDOW];  // as mesmas amostras, em ordem crescente
+    float resolution;                   // menor passo do canal; piso da MAD
+    uint8_t count;                      // amostras na janela
+    uint8_t head;                       // próxima posição do anel
+    uint32_t rejected;                  // amostras atípicas (além de k * 1.4826 * MAD da mediana)
+    uint32_t replaced;                  // amostras cuja saída difere da entrada
+};
+
+/**
+ * @brief Prepara o filtro de um canal e zera os contadores.
+ * @param resolution Menor passo do valor do canal (ex.: 0.1 para CO em ppm).
+ */
+void spike_filter_init(struct spike_filter *f, float resolution);
+
+/**
+ * @brief Esvazia a janela, mantendo os contadores.
+ */
+void spike_filter_reset(struct spike_filter *f);
+
+/**
+ * @brief Insere uma amostra e devolve o valor filtrado. Custo O(SPIKE_FILTER_WINDOW).
+ * A amostra é contada como rejeitada quando é atípica pelo teste de Hampel (nos dois modos, com
+ * a janela cheia) e como substituída quando a saída difere dela. No Hampel os dois contadores
+ * coincidem; na mediana móvel, "substituídas" inclui o atraso da mediana em sinais que variam.
+ */
+float spike_filter_apply(struct spike_filter *f, float x);
+
+#endif /* SPIKE_FILTER_H */
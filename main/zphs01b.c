@@ -1,106 +1,111 @@
 #include <stdio.h>
+#include <stdarg.h>
 #include <string.h>
+#include <inttypes.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "driver/uart.h"
-#include "driver/gpio.h"
+#include "freertos/semphr.h"
 #include "sdkconfig.h"
 #include "esp_log.h"
 #include "zphs01b.h"
+#include "zphs01b_proto.h"
+#include "port.h"
 #include "bt.h"
+#include "dlog.h"
+#include "spike_filter.h"
 
 // --- DEFINIÇÕES GERAIS ---
-// Pinos para a comunicação UART com o sensor, vindos da configuração do projeto (menuconfig)
-#define UART_TXD_PIN (CONFIG_EXAMPLE_UART_TXD)
-#define UART_RXD_PIN (CONFIG_EXAMPLE_UART_RXD)
-#define UART_RTS (UART_PIN_NO_CHANGE)
-#define UART_CTS (UART_PIN_NO_CHANGE)
-// Configurações da porta UART
-#define UART_PORT_NUM      (CONFIG_EXAMPLE_UART_PORT_NUM)
-#define UART_BAUD_RATE     (CONFIG_EXAMPLE_UART_BAUD_RATE)
 #define TASK_STACK_SIZE    (CONFIG_EXAMPLE_TASK_STACK_SIZE)
-// Tamanho do buffer para receber dados da UART
-#define BUF_SIZE           (1024)
 // Tamanho esperado da resposta do sensor (em bytes), conforme o datasheet
-#define RESPONSE_LENGTH    (26)
+#define RESPONSE_LENGTH    (ZPHS01B_FRAME_LEN)
+// Tempo máximo de espera pela resposta do sensor
+#define RESPONSE_TIMEOUT_MS (1000)
 // Tamanho máximo da mensagem formatada para envio via Bluetooth
 #define RESULT_MESSAGE_SIZE (500)
 
 // --- VARIÁVEIS GLOBAIS DO MÓDULO ---
 // Handle (identificador) da tarefa do sensor, para podermos pará-la e iniciá-la
 static TaskHandle_t zphs01b_task_handle = NULL;
+// Protege o handle da tarefa: o console e o Bluetooth podem (re)iniciá-la ao mesmo tempo
+static SemaphoreHandle_t zphs01b_task_lock = NULL;
+// Intervalo da tarefa em execução (0 = parada), protegido por zphs01b_task_lock
+static uint32_t running_rate_ms = 0;
+// Liberado pela tarefa do sensor quando ela atende um pedido de parada e sai do loop
+static SemaphoreHandle_t zphs01b_task_exited = NULL;
 // Tag para os logs deste arquivo, facilita a depuração
 static const char *TAG_UART = "ZPHS01B_UART";
-// Comando exato em bytes para solicitar os dados do sensor ZPHS01B
-static const uint8_t ZPHS01B_DATA_REQUEST[] = {0xff, 0x01, 0x86, 0x00, 0x00, 0x00, 0x00, 0x00, 0x79};
-// Calcula o tamanho do comando de solicitação
-static const uint8_t ZPHS01B_DATA_REQUEST_LEN = sizeof(ZPHS01B_DATA_REQUEST)/sizeof(uint8_t);
+// Buffers da tarefa. São estáticos e reaproveitados a cada reinício, sem alocação;
+// só uma tarefa do sensor existe por vez (a anterior sai antes da nova ser criada).
+static uint8_t response_buf[RESPONSE_LENGTH];
+static char output_message_buf[RESULT_MESSAGE_SIZE];
+// Contadores de leituras e latência (consultados por zphs01b_get_stats)
+static struct zphs01b_stats stats;
+
+#if SPIKE_FILTER_ENABLED
+// Filtro de picos, indexado por ZPHS01B_CH_<CH>; só os canais com filt = 1 na tabela o usam
+static struct spike_filter filters[ZPHS01B_CH_COUNT];
+#define FILTER_INIT_(id, CH, type, ofs, width, num, den, bias, has_lvl, filt, lvl_label, value_fmt) \
+    ZPHS01B_IF_##filt(spike_filter_init(&filters[ZPHS01B_CH_##CH], (float)(num) / (den));)
+#define FILTER_RESET_(id, CH, type, ofs, width, num, den, bias, has_lvl, filt, lvl_label, value_fmt) \
+    ZPHS01B_IF_##filt(spike_filter_reset(&filters[ZPHS01B_CH_##CH]);)
+#define FILTER_FIELD_(id, CH, type, ofs, width, num, den, bias, has_lvl, filt, lvl_label, value_fmt) \
+    ZPHS01B_IF_##filt(output->id = (type)spike_filter_apply(&filters[ZPHS01B_CH_##CH], (float)output->id);)
+#endif
+
+// Log de cada leitura válida. No modo adiado (CONFIG_ZPHS01B_DEFERRED_LOG) a tarefa do sensor
+// grava apenas a struct air_data no anel do dlog; a tarefa de log monta e imprime a mensagem.
+#if CONFIG_ZPHS01B_DEFERRED_LOG
+#define LOG_OUTPUT_MSG(d, msg) dlog_write(DLOG_OUTPUT_MSG, (d), sizeof(*(d)))
+#else
+#define LOG_OUTPUT_MSG(d, msg) ESP_LOGI("OUTPUT_MSG", "%s", (msg))
+#endif
 
 
 // --- ESTRUTURAS DE DADOS ---
-// Enum para classificar os níveis de poluição (Baixo, Médio, Alto, Erro)
-typedef enum lvl {LO = 0, ME = 1, HI = 2, ER = 3} lvl_e;
-// Array de strings para converter o enum em texto legível
-const char *lvls[] = {[LO] = "Low", [ME] = "Med.", [HI] = "High", [ER] = "error"};
-// Estrutura principal que armazena todos os dados lidos e processados do sensor
+// Estrutura principal que armazena todos os dados lidos e processados do sensor.
+// Gerada a partir da tabela de canais: apenas os canais habilitados no menuconfig existem.
+#define AIR_FIELD_(id, CH, type, ofs, width, num, den, bias, has_lvl, filt, lvl_label, value_fmt) \
+    type id; ZPHS01B_IF_##has_lvl(enum zphs01b_lvl id##_lvl;)
 static struct air_data {
-    uint16_t pm1_0;    lvl_e pm1_0_lvl;
-    uint16_t pm2_5;    lvl_e pm2_5_lvl;
-    uint16_t pm10;     lvl_e pm10_lvl;
-    uint16_t co2;      lvl_e co2_lvl;
-    uint8_t  voc;      lvl_e voc_lvl;
-    uint16_t ch2o;     lvl_e ch2o_lvl;
-    double co;         lvl_e co_lvl;
-    uint16_t o3;       lvl_e o3_lvl;
-    uint16_t no2;      lvl_e no2_lvl;
-    double temp;
-    uint16_t humidity; lvl_e humidity_lvl;
+    ZPHS01B_CHANNEL_LIST(AIR_FIELD_)
 } air_data_processed;
 
+_Static_assert(sizeof(struct air_data) <= DLOG_ARGS_MAX, "struct air_data nao cabe em um registro do log adiado");
+_Static_assert(ZPHS01B_CH_COUNT > 0, "Habilite ao menos um canal do ZPHS01B");
+_Static_assert(sizeof(ZPHS01B_CHANNEL_LIST(ZPHS01B_LVL_FMT_) "") > 2,
+               "Habilite ao menos um canal classificado em niveis (todos exceto a temperatura)");
+
 // --- COEFICIENTES DE CALIBRAÇÃO ---
-// Estrutura para armazenar os offsets de calibração para cada medida.
+// Estrutura para armazenar os offsets de calibração para cada medida habilitada.
 // Um offset positivo aumenta o valor final, um negativo diminui.
+// Os offsets são somados ao valor já convertido, na unidade da mensagem de saída:
+// ug/m3, ppm (CO2 e CO), ppb (O3 e NO2), *C e %RH. Canais inteiros usam int16_t e
+// canais com casas decimais (CO, temperatura) usam double.
+#define CAL_TYPE_uint8_t  int16_t
+#define CAL_TYPE_uint16_t int16_t
+#define CAL_TYPE_double   double
+#define CAL_TYPE_(type) CAL_TYPE_##type
+#define CAL_FIELD_(id, CH, type, ofs, width, num, den, bias, has_lvl, filt, lvl_label, value_fmt) CAL_TYPE_(type) id##_offset;
 static struct calibration_offsets {
-    int16_t temp_offset;     // Offset para a fórmula da temperatura.
-    int16_t pm1_0_offset;
-    int16_t pm2_5_offset;
-    int16_t pm10_offset;
-    int16_t co2_offset;
-    int16_t ch2o_offset;     // Unidade: ug/m3 (antes de converter para mg/m3)
-    double  co_offset;       // Unidade: ppm
-    int16_t o3_offset;       // Unidade: ppb
-    int16_t no2_offset;      // Unidade: ppb
-    int16_t humidity_offset; // Unidade: %RH
+    ZPHS01B_CHANNEL_LIST(CAL_FIELD_)
 } cal_offsets = {
-    .temp_offset = 50,       
-    .pm1_0_offset = 0,
-    .pm2_5_offset = 0,
-    .pm10_offset = 0,
-    .co2_offset = 0,
-    .ch2o_offset = 0,
-    .co_offset = 0.0,
-    .o3_offset = 0,
-    .no2_offset = 0,
-    .humidity_offset = 0
+#if ZPHS01B_EN_TEMP
+    .temp_offset = 5.0,      // *C
+#endif
 };
 
 // --- PROTÓTIPOS DE FUNÇÕES ESTÁTICAS ---
 // (Declarações antecipadas das funções usadas apenas neste arquivo)
 static int construct_output_message(const struct air_data *d, char *output_message);
+static int append_output(char *output_message, int *len, const char *fmt, ...) __attribute__((format(printf, 3, 4)));
 static void process_response(const uint8_t *response, const int response_len, struct air_data *output);
 static uint8_t check_response(uint8_t *response, int response_length);
+static void update_stats(int response_len, uint8_t invalid, int64_t t_request, uint32_t cycles, uint32_t log_cycles);
 static void reset_buffers_and_counter(uint8_t *response, int *response_len, char *output_message);
-static lvl_e get_pm1_0_lvl(uint16_t pm1_0);
-static lvl_e get_pm2_5_lvl(uint16_t pm2_5);
-static lvl_e get_pm10_lvl(uint16_t pm10);
-static lvl_e get_co2_lvl(uint16_t co2);
-static lvl_e get_voc_lvl(uint8_t voc);
-static lvl_e get_ch2o_lvl(uint16_t ch2o);
-static lvl_e get_co_lvl(double co);
-static lvl_e get_o3_lvl(uint16_t o3);
-static lvl_e get_no2_lvl(uint16_t no2);
-static lvl_e get_humidity_lvl(uint16_t rh);
 static void zphs01b_task(void *arg);
+#if CONFIG_ZPHS01B_DEFERRED_LOG
+static void expand_output_msg(const void *args, size_t len);
+#endif
 
 
 /**
@@ -109,43 +114,54 @@ static void zphs01b_task(void *arg);
  */
 static void zphs01b_task(void *arg) {
     // Converte o argumento recebido para o intervalo de tempo
-    uint32_t read_data_pause_ms = (uint32_t)arg;
-    ESP_LOGI(TAG_UART, "Task iniciada com intervalo de %lu ms.", read_data_pause_ms);
+    uint32_t read_data_pause_ms = (uint32_t)(uintptr_t)arg;
+    ESP_LOGI(TAG_UART, "Task iniciada com intervalo de %" PRIu32 " ms.", read_data_pause_ms);
 
-    // Aloca memória para os buffers de dados
-    uint8_t *data = (uint8_t *) calloc(BUF_SIZE, sizeof(uint8_t));
+    uint8_t *data = response_buf;
     int len = 0;
-    char *output_message = (char *) calloc(RESULT_MESSAGE_SIZE, sizeof(char));
-    if (data == NULL || output_message == NULL) {
-        ESP_LOGE(TAG_UART, "Erro de alocação de memória.");
-        vTaskDelete(NULL); // Encerra a tarefa se não houver memória
-        return;
-    }
+    char *output_message = output_message_buf;
 
     // Loop infinito da tarefa
     while (1) {
+        // Descarta respostas atrasadas ou ruído de ciclos anteriores para manter o alinhamento
+        port_sensor_flush();
+        int64_t t_request = port_time_us();
         // Envia o comando para o sensor pedindo novos dados
-        uart_write_bytes(UART_PORT_NUM, ZPHS01B_DATA_REQUEST, ZPHS01B_DATA_REQUEST_LEN);
-        // Lê a resposta do sensor com um timeout de 1 segundo
-        len = uart_read_bytes(UART_PORT_NUM, data, (BUF_SIZE - 1), pdMS_TO_TICKS(1000));
-        
+        port_sensor_write(ZPHS01B_DATA_REQUEST, ZPHS01B_REQUEST_LEN);
+        // Lê exatamente uma resposta, com timeout de 1 segundo
+        len = port_sensor_read(data, RESPONSE_LENGTH, RESPONSE_TIMEOUT_MS);
+
         // Verifica se a resposta do sensor é válida (checksum)
-        if (check_response(data, len)) {
+        uint8_t invalid = check_response(data, len);
+        uint32_t cycles = 0, log_cycles = 0;
+        if (invalid) {
             ESP_LOGW(TAG_UART, "Resposta do sensor invalida.");
         } else {
+            uint32_t c_start = port_cycle_count();
             // Se for válida, processa os bytes e converte para valores legíveis
             process_response(data, len, &air_data_processed);
             // Formata a mensagem final para ser enviada
-            if (construct_output_message(&air_data_processed, output_message)) {
+            int built = construct_output_message(&air_data_processed, output_message);
+            cycles = port_cycle_count() - c_start;
+            if (built) {
+                uint32_t c_log = port_cycle_count();
+                LOG_OUTPUT_MSG(&air_data_processed, output_message);
+                log_cycles = port_cycle_count() - c_log;
                 // Envia a mensagem via Bluetooth
                 send_message(output_message);
             }
         }
+        update_stats(len, invalid, t_request, cycles, log_cycles);
         // Limpa os buffers para a próxima leitura
         reset_buffers_and_counter(data, &len, output_message);
-        // Pausa a tarefa pelo intervalo de tempo definido pelo usuário
-        vTaskDelay(pdMS_TO_TICKS(read_data_pause_ms));
+        // Pausa a tarefa pelo intervalo de tempo definido pelo usuário. Um pedido de parada
+        // (notificação de zphs01b_task_stop) acorda a tarefa e a encerra aqui, nunca no meio
+        // do envio por SPP, de uma leitura da UART ou de uma gravação no log adiado.
+        if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(read_data_pause_ms)) != 0) break;
     }
+
+    xSemaphoreGive(zphs01b_task_exited);
+    vTaskDelete(NULL);
 }
 
 /**
@@ -153,168 +169,142 @@ static void zphs01b_task(void *arg) {
  * Esta função deve ser chamada apenas uma vez no início do programa.
  */
 void zphs01b_uart_init(void) {
-    // Estrutura de configuração da UART
-    uart_config_t uart_config = {
-        .baud_rate = UART_BAUD_RATE,
-        .data_bits = UART_DATA_8_BITS,
-        .parity    = UART_PARITY_DISABLE,
-        .stop_bits = UART_STOP_BITS_1,
-        .flow_ctrl = UART_HW_FLOWCTRL_DISABLE,
-        .source_clk = UART_SCLK_DEFAULT,
-    };
-    // Instala e configura o driver UART com os pinos definidos
-    ESP_ERROR_CHECK(uart_driver_install(UART_PORT_NUM, BUF_SIZE * 2, 0, 0, NULL, 0));
-    ESP_ERROR_CHECK(uart_param_config(UART_PORT_NUM, &uart_config));
-    ESP_ERROR_CHECK(uart_set_pin(UART_PORT_NUM, UART_TXD_PIN, UART_RXD_PIN, UART_RTS, UART_CTS));
+    port_sensor_init();
+#if CONFIG_ZPHS01B_DEFERRED_LOG
+    dlog_register(DLOG_OUTPUT_MSG, expand_output_msg);
+#endif
+#if SPIKE_FILTER_ENABLED
+    ZPHS01B_CHANNEL_LIST(FILTER_INIT_)
+#endif
+    zphs01b_task_lock = xSemaphoreCreateMutex();
+    if (zphs01b_task_lock == NULL) {
+        ESP_LOGE(TAG_UART, "Erro ao criar o mutex da tarefa do sensor.");
+    }
+    zphs01b_task_exited = xSemaphoreCreateBinary();
+    if (zphs01b_task_exited == NULL) {
+        ESP_LOGE(TAG_UART, "Erro ao criar o semaforo de parada da tarefa do sensor.");
+    }
     ESP_LOGI(TAG_UART, "Driver UART do sensor ZPHS01B inicializado.");
 }
 
 /**
- * @brief Funções que classificam os valores lidos em níveis (Baixo, Médio, Alto).
- * Os valores de referência são baseados em padrões de qualidade do ar.
+ * @brief Formata a string final com todos os dados para ser exibida.
+ * As linhas de níveis e de valores vêm da tabela de canais em zphs01b_proto.h,
+ * a mesma usada pelo decodificador de host (tools/zphs01b_decode).
  */
-static lvl_e get_pm1_0_lvl(uint16_t pm1_0) {
-    if (pm1_0 <= 10) return LO;
-    else if (pm1_0 <= 25) return ME;
-    else if (pm1_0 <= 1000) return HI;
-    else return ER;
-}
-
-static lvl_e get_pm2_5_lvl(uint16_t pm2_5) {
-    if (pm2_5 < 14) return LO;
-    else if (pm2_5 < 25) return ME;
-    else if (pm2_5 <= 1000) return HI;
-    else return ER;
-}
-
-static lvl_e get_pm10_lvl(uint16_t pm10) {
-    if (pm10 < 20) return LO;
-    else if (pm10 < 50) return ME;
-    else if (pm10 <= 1000) return HI;
-    else return ER;
-}
-
-static lvl_e get_co2_lvl(uint16_t co2) {
-    if (co2 <= 700) return LO;
-    else if (co2 <= 1200) return ME;
-    else if (co2 <= 5000) return HI;
-    else return ER;
-}
-
-static lvl_e get_voc_lvl(uint8_t voc) {
-    if (voc == 0) return LO;
-    else if (voc == 1) return ME;
-    else if (voc == 2 || voc == 3) return HI;
-    else return ER;
-}
-
-static lvl_e get_ch2o_lvl(uint16_t ch2o) {
-    if (ch2o < 10) return LO;
-    else if (ch2o < 36) return ME;
-    else if (ch2o <= 6250) return HI;
-    else return ER;
-}
-
-static lvl_e get_co_lvl(double co) {
-    if (co >= 0 && co < 9) return LO;
-    else if (co < 25) return ME;
-    else if (co <= 500) return HI;
-    else return ER;
-}
+#define LVL_ARG_EXPR_(id) , zphs01b_lvl_names[d->id##_lvl]
+#define LVL_ARG_(id, CH, type, ofs, width, num, den, bias, has_lvl, filt, lvl_label, value_fmt) ZPHS01B_IF_##has_lvl(LVL_ARG_EXPR_(id))
+#define VAL_ARG_(id, CH, type, ofs, width, num, den, bias, has_lvl, filt, lvl_label, value_fmt) , d->id
 
-static lvl_e get_o3_lvl(uint16_t o3) {
-    if (o3 < 21) return LO;
-    else if (o3 < 55) return ME;
-    else if (o3 <= 10000) return HI;
-    else return ER;
+static int construct_output_message(const struct air_data *d, char *output_message) {
+    if (output_message == NULL) return 0;
+    int len = 0;
+    // Monta a mensagem em partes: níveis, valores e a instrução ao usuário
+    if (!append_output(output_message, &len, "\n\n") ||
+        !append_output(output_message, &len, ZPHS01B_MSG_LEVELS_FMT ZPHS01B_CHANNEL_LIST(LVL_ARG_)) ||
+        !append_output(output_message, &len, ";\n") ||
+        !append_output(output_message, &len, ZPHS01B_MSG_VALUES_FMT ZPHS01B_CHANNEL_LIST(VAL_ARG_)) ||
+        !append_output(output_message, &len, ";\n\n>> Caso queira alterar a frequencia de recebimento de dados, aperte 'X'.\n")) {
+        output_message[0] = '\0';
+        return 0;
+    }
+    return 1;
 }
 
-static lvl_e get_no2_lvl(uint16_t no2) {
-    if (no2 < 51) return LO;
-    else if (no2 < 100) return ME;
-    else if (no2 <= 10000) return HI;
-    else return ER;
+/**
+ * @brief Acrescenta texto formatado à mensagem de saída.
+ * @return 1 se coube em RESULT_MESSAGE_SIZE, 0 caso contrário.
+ */
+static int append_output(char *output_message, int *len, const char *fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    int rv = vsnprintf(output_message + *len, RESULT_MESSAGE_SIZE - *len, fmt, args);
+    va_end(args);
+    if (rv < 0 || *len + rv >= RESULT_MESSAGE_SIZE) return 0;
+    *len += rv;
+    return 1;
 }
 
-static lvl_e get_humidity_lvl(uint16_t rh) {
-    if (rh < 30) return LO;
-    else if (rh <= 68) return ME;
-    else if (rh <= 100) return HI;
-    else return ER;
-}
+#if CONFIG_ZPHS01B_DEFERRED_LOG
+// Buffer da tarefa de log, separado do buffer da tarefa do sensor
+static char dlog_message_buf[RESULT_MESSAGE_SIZE];
 
 /**
- * @brief Formata a string final com todos os dados para ser exibida.
+ * @brief Expande um registro DLOG_OUTPUT_MSG: monta a mensagem a partir da struct air_data gravada.
+ * Roda na tarefa de log adiado.
  */
-static int construct_output_message(const struct air_data *d, char *output_message) {
-    if (output_message == NULL) return 0;
-    // Usa sprintf para montar a mensagem com os níveis e os valores numéricos
-    int rv = sprintf(output_message,
-          "\n\npm1.0 %s, pm2.5 %s, pm10 %s, CO2 %s, TVOC %s, CH2O %s, CO %s, O3 %s, NO2 %s, RH %s;\n"
-          "pm1.0 %d ug/m3, pm2.5 %d ug/m3, pm10 %d ug/m3, CO2 %d ppm, TVOC %d lvl, CH2O %d ug/m3, CO %.1f ppm, O3 %d ppb, NO2 %d ppb, %.1f *C, %d%% RH;\n"
-          "\n>> Caso queira alterar a frequencia de recebimento de dados, aperte 'X'.\n",
-           lvls[d->pm1_0_lvl], lvls[d->pm2_5_lvl], lvls[d->pm10_lvl], lvls[d->co2_lvl], lvls[d->voc_lvl], lvls[d->ch2o_lvl], lvls[d->co_lvl], lvls[d->o3_lvl], lvls[d->no2_lvl], lvls[d->humidity_lvl],
-            d->pm1_0, d->pm2_5, d->pm10, d->co2, d->voc, d->ch2o, d->co, d->o3, d->no2, d->temp, d->humidity);
-
-        if (rv <= 0) { output_message[0] = '\0'; return 0; }
-
-        ESP_LOGI("OUTPUT_MSG", "%s", output_message);
-
-         return 1;
-
+static void expand_output_msg(const void *args, size_t len) {
+    struct air_data d;
+    if (len != sizeof(d)) return;
+    memcpy(&d, args, sizeof(d));
+    if (construct_output_message(&d, dlog_message_buf)) {
+        ESP_LOGI("OUTPUT_MSG", "%s", dlog_message_buf);
+    }
 }
+#endif
+
 /**
  * @brief Processa o array de bytes recebido do sensor e preenche a struct air_data.
  * A ordem e o cálculo dos bytes seguem o datasheet do ZPHS01B.
  */
+#define DECODE_FIELD_(id, CH, type, ofs, width, num, den, bias, has_lvl, filt, lvl_label, value_fmt) \
+    output->id = (type)((type)(zphs01b_raw_value(response, ofs, width) + (bias)) * (num) / (den) + cal_offsets.id##_offset);
+#define CLASSIFY_EXPR_(id) output->id##_lvl = zphs01b_##id##_lvl(output->id);
+#define CLASSIFY_FIELD_(id, CH, type, ofs, width, num, den, bias, has_lvl, filt, lvl_label, value_fmt) \
+    ZPHS01B_IF_##has_lvl(CLASSIFY_EXPR_(id))
+
 static void process_response(const uint8_t *response, const int response_len, struct air_data *output) {
     if (response_len != RESPONSE_LENGTH) return;
 
-    // Converte os bytes brutos para valores numéricos e aplica os offsets de calibração
-    output->pm1_0    = (response[2] * 256 + response[3])   + cal_offsets.pm1_0_offset;
-    output->pm2_5    = (response[4] * 256 + response[5])   + cal_offsets.pm2_5_offset;
-    output->pm10     = (response[6] * 256 + response[7])   + cal_offsets.pm10_offset;
-    output->co2      = (response[8] * 256 + response[9])   + cal_offsets.co2_offset;
-    output->voc      = response[10]; // VOC é um nível (0-3), sem offset numérico.
-    output->humidity = (response[13] * 256 + response[14]) + cal_offsets.humidity_offset;
-    output->ch2o     = (response[15] * 256 + response[16]) + cal_offsets.ch2o_offset; // Offset aplicado no valor em ug/m3
-
-    // Cálculo da Temperatura: (RAW - 500 + OFFSET) * 0.1
-    // Usando a fórmula do datasheet (-500) com o offset de calibração (+50).
-    output->temp     = (((response[11] * 256) + response[12]) - 500 + cal_offsets.temp_offset) * 0.1;
-
-    // Cálculos que exigem conversão de unidade após o offset
-    output->co       = ((response[17] * 256 + response[18]) * 0.1)  + cal_offsets.co_offset;
-    output->o3       = ((response[19] * 256 + response[20]) * 10)   + cal_offsets.o3_offset;  // O datasheet indica 0.01ppm, que é 10ppb. O offset é em ppb.
-    output->no2      = ((response[21] * 256 + response[22]) * 10)   + cal_offsets.no2_offset; // O datasheet indica 0.01ppm, que é 10ppb. O offset é em ppb.
+    // Converte os bytes brutos para valores numéricos e aplica os offsets de calibração:
+    // (RAW + bias) * num / den + OFFSET, com os coeficientes da tabela em zphs01b_proto.h.
+    // Ex.: temperatura = (RAW - 500) / 10 + 5.0 *C; O3 = RAW * 10 ppb (o datasheet indica 0.01 ppm).
+    ZPHS01B_CHANNEL_LIST(DECODE_FIELD_)
 
+#if SPIKE_FILTER_ENABLED
+    // Remove picos isolados antes da classificação, para que um valor espúrio não vire "High"/"error"
+    ZPHS01B_CHANNEL_LIST(FILTER_FIELD_)
+#endif
 
     // Classifica os valores FINAIS (já calibrados) em níveis
-    output->pm1_0_lvl    = get_pm1_0_lvl(output->pm1_0);
-    output->pm2_5_lvl    = get_pm2_5_lvl(output->pm2_5);
-    output->pm10_lvl     = get_pm10_lvl(output->pm10);
-    output->co2_lvl      = get_co2_lvl(output->co2);
-    output->voc_lvl      = get_voc_lvl(output->voc);
-    output->humidity_lvl = get_humidity_lvl(output->humidity);
-    output->ch2o_lvl     = get_ch2o_lvl(output->ch2o);
-    output->co_lvl       = get_co_lvl(output->co);
-    output->o3_lvl       = get_o3_lvl(output->o3);
-    output->no2_lvl      = get_no2_lvl(output->no2);
+    ZPHS01B_CHANNEL_LIST(CLASSIFY_FIELD_)
 }
 
 /**
  * @brief Valida a resposta do sensor calculando e comparando o checksum.
  */
 static uint8_t check_response(uint8_t *response, int response_length) {
-    uint8_t checksum = 0;
-    if (response_length != RESPONSE_LENGTH) { return 1; }
-    // Soma todos os bytes da resposta (exceto o primeiro e o último)
-    for (int i = 1; i < 25; i++) { checksum += response[i]; }
-    // Aplica a fórmula do datasheet: invert + 1
-    checksum = ~checksum + 1;
-    // Compara com o byte de checksum enviado pelo sensor (o último byte)
-    if (checksum != response[25]) { return 1; } // Retorna 1 se houver erro
-    return 0; // Retorna 0 se estiver ok
+    // Tamanho, cabeçalho e checksum conforme o datasheet (ver zphs01b_proto.c)
+    return zphs01b_check_frame(response, response_length);
+}
+
+/**
+ * @brief Contabiliza o resultado de um ciclo de leitura.
+ * A latência vai do envio do comando até o fim do envio da mensagem; os ciclos
+ * cobrem apenas decodificação, classificação e formatação (sem log nem envio), e
+ * log_cycles apenas o ponto de log OUTPUT_MSG.
+ */
+static void update_stats(int response_len, uint8_t invalid, int64_t t_request, uint32_t cycles, uint32_t log_cycles) {
+    stats.requests++;
+    if (response_len < RESPONSE_LENGTH) {
+        stats.timeouts++;
+        return;
+    }
+    if (invalid) {
+        stats.invalid++;
+        return;
+    }
+    uint32_t latency = (uint32_t)(port_time_us() - t_request);
+    if (stats.valid == 0 || latency < stats.latency_min_us) stats.latency_min_us = latency;
+    if (latency > stats.latency_max_us) stats.latency_max_us = latency;
+    stats.latency_total_us += latency;
+    if (stats.valid == 0 || cycles < stats.cycles_min) stats.cycles_min = cycles;
+    if (cycles > stats.cycles_max) stats.cycles_max = cycles;
+    stats.cycles_total += cycles;
+    if (stats.valid == 0 || log_cycles < stats.log_cycles_min) stats.log_cycles_min = log_cycles;
+    if (log_cycles > stats.log_cycles_max) stats.log_cycles_max = log_cycles;
+    stats.log_cycles_total += log_cycles;
+    stats.valid++;
 }
 
 /**
@@ -327,28 +317,74 @@ static void reset_buffers_and_counter(uint8_t *response, int *response_len, char
 }
 
 
+/**
+ * @brief Pede à tarefa do sensor que pare e espera ela sair do loop. Chamar com zphs01b_task_lock.
+ * A tarefa só sai na pausa entre leituras, então a espera pode durar um ciclo inteiro
+ * (até RESPONSE_TIMEOUT_MS mais o envio da mensagem).
+ */
+static void zphs01b_task_stop(void) {
+    if (zphs01b_task_handle == NULL) return;
+    xTaskNotifyGive(zphs01b_task_handle);
+    xSemaphoreTake(zphs01b_task_exited, portMAX_DELAY);
+    zphs01b_task_handle = NULL;
+}
+
+
 // --- FUNÇÕES PÚBLICAS (Chamadas por outros arquivos, como o main.c) ---
 
 /**
  * @brief Cria e inicia a tarefa do sensor com um intervalo de tempo específico.
- * Se uma tarefa antiga existir, ela é deletada primeiro.
+ * Se uma tarefa antiga existir, ela é parada primeiro (ver zphs01b_task_stop).
  * @param delay_ms Intervalo de tempo entre as leituras.
  */
 void init_and_run_zphs01b(uint32_t delay_ms) {
-    if (zphs01b_task_handle != NULL) {
-        vTaskDelete(zphs01b_task_handle);
-        zphs01b_task_handle = NULL;
+    if (zphs01b_task_exited == NULL) {
+        ESP_LOGE(TAG_UART, "Tarefa do sensor nao iniciada: zphs01b_uart_init falhou.");
+        return;
     }
+    if (zphs01b_task_lock != NULL) xSemaphoreTake(zphs01b_task_lock, portMAX_DELAY);
+    zphs01b_task_stop();
+#if SPIKE_FILTER_ENABLED
+    // Com a tarefa parada, amostras antigas da janela não representam mais o sinal
+    ZPHS01B_CHANNEL_LIST(FILTER_RESET_)
+#endif
     // Cria a tarefa e armazena seu handle (identificador)
-    xTaskCreate(zphs01b_task, "zphs01b_task", TASK_STACK_SIZE, (void*)delay_ms, 10, &zphs01b_task_handle);
+    xTaskCreate(zphs01b_task, "zphs01b_task", TASK_STACK_SIZE, (void *)(uintptr_t)delay_ms, 10, &zphs01b_task_handle);
+    running_rate_ms = zphs01b_task_handle != NULL ? delay_ms : 0;
+    if (zphs01b_task_lock != NULL) xSemaphoreGive(zphs01b_task_lock);
 }
 
 /**
- * @brief Para e deleta a tarefa do sensor.
+ * @brief Copia os contadores de leitura do sensor.
+ * A cópia não é atômica em relação à tarefa; serve para diagnóstico.
  */
-void stop_zphs01b_task(void) {
-    if (zphs01b_task_handle != NULL) {
-        vTaskDelete(zphs01b_task_handle);
-        zphs01b_task_handle = NULL;
+void zphs01b_get_stats(struct zphs01b_stats *out) {
+    if (out == NULL) return;
+    *out = stats;
+#if SPIKE_FILTER_ENABLED
+    for (int i = 0; i < ZPHS01B_CH_COUNT; i++) {
+        out->filter_rejected[i] = filters[i].rejected;
+        out->filter_replaced[i] = filters[i].replaced;
     }
+#endif
+}
+
+/**
+ * @brief Para a tarefa do sensor e espera ela terminar o ciclo em andamento.
+ */
+void stop_zphs01b_task(void) {
+    if (zphs01b_task_lock != NULL) xSemaphoreTake(zphs01b_task_lock, portMAX_DELAY);
+    zphs01b_task_stop();
+    running_rate_ms = 0;
+    if (zphs01b_task_lock != NULL) xSemaphoreGive(zphs01b_task_lock);
+}
+
+/**
+ * @brief Intervalo da tarefa do sensor em execução, 0 se estiver parada.
+ */
+uint32_t zphs01b_get_rate(void) {
+    if (zphs01b_task_lock != NULL) xSemaphoreTake(zphs01b_task_lock, portMAX_DELAY);
+    uint32_t rate = running_rate_ms;
+    if (zphs01b_task_lock != NULL) xSemaphoreGive(zphs01b_task_lock);
+    return rate;
 }
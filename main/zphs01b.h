@@ -2,6 +2,33 @@
 #define ZPHS01B_H
 
 #include <stdint.h>
+#include "zphs01b_proto.h"
+
+/**
+ * @brief Contadores dos ciclos de leitura do sensor.
+ */
+struct zphs01b_stats {
+    uint32_t requests;         // Comandos de leitura enviados
+    uint32_t valid;            // Respostas válidas processadas
+    uint32_t invalid;          // Respostas completas com cabeçalho ou checksum inválido
+    uint32_t timeouts;         // Respostas ausentes ou incompletas
+    uint32_t latency_min_us;   // Latência (comando -> mensagem enviada) das respostas válidas
+    uint32_t latency_max_us;
+    uint64_t latency_total_us;
+    uint32_t cycles_min;       // Ciclos de CPU para decodificar, classificar e formatar uma resposta válida
+    uint32_t cycles_max;
+    uint64_t cycles_total;
+    uint32_t log_cycles_min;   // Ciclos de CPU do log de cada resposta válida (imediato ou adiado)
+    uint32_t log_cycles_max;
+    uint64_t log_cycles_total;
+    // Filtro de picos, por canal (sempre 0 nos canais com filt = 0 ou com o filtro desligado):
+    // rejected conta os valores atípicos, |x - mediana| > k * 1.4826 * MAD com a janela cheia,
+    // tanto no Hampel quanto na mediana móvel; replaced conta as amostras em que a saída do
+    // filtro difere da entrada (no Hampel é igual a rejected; na mediana móvel inclui o
+    // atraso da mediana em sinais que variam).
+    uint32_t filter_rejected[ZPHS01B_CH_COUNT];
+    uint32_t filter_replaced[ZPHS01B_CH_COUNT];
+};
 
 /**
  * @brief Inicializa o driver da UART para comunicação com o sensor.
@@ -11,14 +38,26 @@ void zphs01b_uart_init(void);
 
 /**
  * @brief Cria e inicia a tarefa do sensor com um intervalo de tempo específico.
- * Se uma tarefa antiga existir, ela é deletada primeiro.
+ * Se uma tarefa antiga existir, ela é parada primeiro, ao fim do ciclo de leitura em andamento.
  * @param delay_ms Intervalo de tempo entre as leituras.
  */
 void init_and_run_zphs01b(uint32_t delay_ms);
 
 /**
- * @brief Para e deleta a tarefa do sensor.
+ * @brief Copia os contadores de leitura do sensor.
+ */
+void zphs01b_get_stats(struct zphs01b_stats *out);
+
+/**
+ * @brief Para a tarefa do sensor. Retorna depois que ela termina o ciclo em andamento
+ * (até 1 s de espera pela resposta do sensor mais o envio da mensagem).
  */
 void stop_zphs01b_task(void);
 
+/**
+ * @brief Intervalo da tarefa do sensor em execução (definido pelo console ou via Bluetooth).
+ * @return Intervalo em ms, ou 0 se a tarefa estiver parada.
+ */
+uint32_t zphs01b_get_rate(void);
+
 #endif /* ZPHS01B_H */
\ No newline at end of file
@@ -0,0 +1,34 @@
+#include "zphs01b_proto.h"
+
+const uint8_t ZPHS01B_DATA_REQUEST[ZPHS01B_REQUEST_LEN] = {0xff, 0x01, 0x86, 0x00, 0x00, 0x00, 0x00, 0x00, 0x79};
+
+#define CHANNEL_INFO_(id, CH, type, ofs, width, num, den, bias, has_lvl, filt, lvl_label, value_fmt) \
+    [ZPHS01B_CH_##CH] = {#id, value_fmt, ofs, width, num, den, bias},
+const struct zphs01b_channel_info zphs01b_channels[ZPHS01B_CH_COUNT] = { ZPHS01B_CHANNEL_LIST(CHANNEL_INFO_) };
+
+const char *const zphs01b_lvl_names[4] = {
+    [ZPHS01B_LVL_LO] = "Low", [ZPHS01B_LVL_ME] = "Med.", [ZPHS01B_LVL_HI] = "High", [ZPHS01B_LVL_ER] = "error",
+};
+
+uint8_t zphs01b_checksum(const uint8_t *packet, size_t len) {
+    uint8_t checksum = 0;
+    // Soma todos os bytes do pacote (exceto o primeiro e o último)
+    for (size_t i = 1; i + 1 < len; i++) { checksum += packet[i]; }
+    // Aplica a fórmula do datasheet: invert + 1
+    return (uint8_t)(~checksum + 1);
+}
+
+uint8_t zphs01b_check_frame(const uint8_t *frame, int frame_len) {
+    if (frame_len != ZPHS01B_FRAME_LEN) { return 1; }
+    if (frame[0] != ZPHS01B_FRAME_START || frame[1] != ZPHS01B_CMD_READ) { return 1; }
+    // Compara com o byte de checksum enviado pelo sensor (o último byte)
+    if (zphs01b_checksum(frame, ZPHS01B_FRAME_LEN) != frame[ZPHS01B_FRAME_LEN - 1]) { return 1; }
+    return 0;
+}
+
+void zphs01b_decode(const uint8_t *frame, double values[ZPHS01B_CH_COUNT]) {
+#define DECODE_(id, CH, type, ofs, width, num, den, bias, has_lvl, filt, lvl_label, value_fmt) \
+    values[ZPHS01B_CH_##CH] = ((double)zphs01b_raw_value(frame, ofs, width) + (bias)) * (num) / (den);
+    ZPHS01B_CHANNEL_LIST(DECODE_)
+#undef DECODE_
+}
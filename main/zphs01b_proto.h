@@ -0,0 +1,271 @@
+#ifndef ZPHS01B_PROTO_H
+#define ZPHS01B_PROTO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#ifdef ESP_PLATFORM
+#include "sdkconfig.h"
+#endif
+
+// Definições do protocolo serial do ZPHS01B, sem dependência do ESP-IDF.
+// Compartilhadas pelo firmware e pelas ferramentas de host (emulador, decodificador).
+
+// Tamanho do comando de leitura e da resposta do sensor (em bytes), conforme o datasheet
+#define ZPHS01B_REQUEST_LEN   (9)
+#define ZPHS01B_FRAME_LEN     (26)
+// Cabeçalho da resposta: byte inicial e código do comando respondido
+#define ZPHS01B_FRAME_START   (0xFF)
+#define ZPHS01B_CMD_READ      (0x86)
+
+// Posição de cada medida na resposta (byte mais significativo; as de 16 bits ocupam dois bytes, big-endian)
+#define ZPHS01B_OFS_PM1_0     (2)
+#define ZPHS01B_OFS_PM2_5     (4)
+#define ZPHS01B_OFS_PM10      (6)
+#define ZPHS01B_OFS_CO2       (8)
+#define ZPHS01B_OFS_VOC       (10)  // 1 byte, nível 0-3
+#define ZPHS01B_OFS_TEMP      (11)  // (RAW - 500) * 0.1 *C
+#define ZPHS01B_OFS_HUMIDITY  (13)
+#define ZPHS01B_OFS_CH2O      (15)  // ug/m3
+#define ZPHS01B_OFS_CO        (17)  // 0.1 ppm
+#define ZPHS01B_OFS_O3        (19)  // 0.01 ppm
+#define ZPHS01B_OFS_NO2       (21)  // 0.01 ppm
+
+// Seleção de canais em tempo de compilação (menuconfig > ZPHS01B channels). Sem
+// CONFIG_ZPHS01B_CHANNEL_SELECT (ou fora do ESP-IDF, nas ferramentas de host) todos os canais
+// são habilitados. Um canal desabilitado some da tabela abaixo e, portanto, do struct, da
+// decodificação, da classificação e da mensagem, sem nenhum teste em tempo de execução.
+#if !defined(CONFIG_ZPHS01B_CHANNEL_SELECT) || defined(CONFIG_ZPHS01B_CH_PM1_0)
+#define ZPHS01B_EN_PM1_0 1
+#else
+#define ZPHS01B_EN_PM1_0 0
+#endif
+#if !defined(CONFIG_ZPHS01B_CHANNEL_SELECT) || defined(CONFIG_ZPHS01B_CH_PM2_5)
+#define ZPHS01B_EN_PM2_5 1
+#else
+#define ZPHS01B_EN_PM2_5 0
+#endif
+#if !defined(CONFIG_ZPHS01B_CHANNEL_SELECT) || defined(CONFIG_ZPHS01B_CH_PM10)
+#define ZPHS01B_EN_PM10 1
+#else
+#define ZPHS01B_EN_PM10 0
+#endif
+#if !defined(CONFIG_ZPHS01B_CHANNEL_SELECT) || defined(CONFIG_ZPHS01B_CH_CO2)
+#define ZPHS01B_EN_CO2 1
+#else
+#define ZPHS01B_EN_CO2 0
+#endif
+#if !defined(CONFIG_ZPHS01B_CHANNEL_SELECT) || defined(CONFIG_ZPHS01B_CH_VOC)
+#define ZPHS01B_EN_VOC 1
+#else
+#define ZPHS01B_EN_VOC 0
+#endif
+#if !defined(CONFIG_ZPHS01B_CHANNEL_SELECT) || defined(CONFIG_ZPHS01B_CH_CH2O)
+#define ZPHS01B_EN_CH2O 1
+#else
+#define ZPHS01B_EN_CH2O 0
+#endif
+#if !defined(CONFIG_ZPHS01B_CHANNEL_SELECT) || defined(CONFIG_ZPHS01B_CH_CO)
+#define ZPHS01B_EN_CO 1
+#else
+#define ZPHS01B_EN_CO 0
+#endif
+#if !defined(CONFIG_ZPHS01B_CHANNEL_SELECT) || defined(CONFIG_ZPHS01B_CH_O3)
+#define ZPHS01B_EN_O3 1
+#else
+#define ZPHS01B_EN_O3 0
+#endif
+#if !defined(CONFIG_ZPHS01B_CHANNEL_SELECT) || defined(CONFIG_ZPHS01B_CH_NO2)
+#define ZPHS01B_EN_NO2 1
+#else
+#define ZPHS01B_EN_NO2 0
+#endif
+#if !defined(CONFIG_ZPHS01B_CHANNEL_SELECT) || defined(CONFIG_ZPHS01B_CH_TEMP)
+#define ZPHS01B_EN_TEMP 1
+#else
+#define ZPHS01B_EN_TEMP 0
+#endif
+#if !defined(CONFIG_ZPHS01B_CHANNEL_SELECT) || defined(CONFIG_ZPHS01B_CH_HUMIDITY)
+#define ZPHS01B_EN_HUMIDITY 1
+#else
+#define ZPHS01B_EN_HUMIDITY 0
+#endif
+
+// ZPHS01B_IF_0/1(...) descartam ou mantêm o argumento; ZPHS01B_WHEN(en, ...) faz o mesmo
+// depois de expandir ZPHS01B_EN_<CH>. São variádicos porque a expansão de X pode conter vírgulas.
+#define ZPHS01B_IF_0(...)
+#define ZPHS01B_IF_1(...) __VA_ARGS__
+#define ZPHS01B_WHEN(en, ...) ZPHS01B_WHEN_(en, __VA_ARGS__)
+#define ZPHS01B_WHEN_(en, ...) ZPHS01B_IF_##en(__VA_ARGS__)
+
+// Tabela de canais habilitados, na ordem em que aparecem na mensagem de saída (construct_output_message).
+// X(id, CH, type, ofs, width, num, den, bias, has_lvl, filt, lvl_label, value_fmt)
+//   type          : tipo C do valor no firmware (e do argumento em value_fmt)
+//   ofs, width    : posição e tamanho (bytes) do valor bruto na resposta
+//   num, den, bias: valor = (bruto + bias) * num / den; com type inteiro a conta é toda inteira
+//   has_lvl       : 1 se o canal é classificado em níveis (Low/Med./High/error)
+//   filt          : 1 se o filtro de picos se aplica ao canal (valor contínuo com níveis;
+//                   não se aplica ao TVOC, que já é um nível 0-3, nem à temperatura)
+//   lvl_label     : rótulo do canal na linha de níveis
+//   value_fmt     : trecho da linha de valores; o decodificador de host usa o mesmo texto para interpretá-la
+#define ZPHS01B_CHANNEL_LIST(X) \
+    ZPHS01B_WHEN(ZPHS01B_EN_PM1_0,    X(pm1_0,    PM1_0,    uint16_t, ZPHS01B_OFS_PM1_0,    2, 1,  1,    0, 1, 1, "pm1.0", "pm1.0 %d ug/m3")) \
+    ZPHS01B_WHEN(ZPHS01B_EN_PM2_5,    X(pm2_5,    PM2_5,    uint16_t, ZPHS01B_OFS_PM2_5,    2, 1,  1,    0, 1, 1, "pm2.5", "pm2.5 %d ug/m3")) \
+    ZPHS01B_WHEN(ZPHS01B_EN_PM10,     X(pm10,     PM10,     uint16_t, ZPHS01B_OFS_PM10,     2, 1,  1,    0, 1, 1, "pm10",  "pm10 %d ug/m3"))  \
+    ZPHS01B_WHEN(ZPHS01B_EN_CO2,      X(co2,      CO2,      uint16_t, ZPHS01B_OFS_CO2,      2, 1,  1,    0, 1, 1, "CO2",   "CO2 %d ppm"))     \
+    ZPHS01B_WHEN(ZPHS01B_EN_VOC,      X(voc,      VOC,      uint8_t,  ZPHS01B_OFS_VOC,      1, 1,  1,    0, 1, 0, "TVOC",  "TVOC %d lvl"))    \
+    ZPHS01B_WHEN(ZPHS01B_EN_CH2O,     X(ch2o,     CH2O,     uint16_t, ZPHS01B_OFS_CH2O,     2, 1,  1,    0, 1, 1, "CH2O",  "CH2O %d ug/m3"))  \
+    ZPHS01B_WHEN(ZPHS01B_EN_CO,       X(co,       CO,       double,   ZPHS01B_OFS_CO,       2, 1,  10,   0, 1, 1, "CO",    "CO %.1f ppm"))    \
+    ZPHS01B_WHEN(ZPHS01B_EN_O3,       X(o3,       O3,       uint16_t, ZPHS01B_OFS_O3,       2, 10, 1,    0, 1, 1, "O3",    "O3 %d ppb"))      \
+    ZPHS01B_WHEN(ZPHS01B_EN_NO2,      X(no2,      NO2,      uint16_t, ZPHS01B_OFS_NO2,      2, 10, 1,    0, 1, 1, "NO2",   "NO2 %d ppb"))     \
+    ZPHS01B_WHEN(ZPHS01B_EN_TEMP,     X(temp,     TEMP,     double,   ZPHS01B_OFS_TEMP,     2, 1,  10, -500, 0, 0, "",      "%.1f *C"))        \
+    ZPHS01B_WHEN(ZPHS01B_EN_HUMIDITY, X(humidity, HUMIDITY, uint16_t, ZPHS01B_OFS_HUMIDITY, 2, 1,  1,    0, 1, 1, "RH",    "%d%% RH"))
+
+// Índice de cada canal (ZPHS01B_CH_PM1_0, ...) e total de canais
+#define ZPHS01B_CH_ENUM_(id, CH, type, ofs, width, num, den, bias, has_lvl, filt, lvl_label, value_fmt) ZPHS01B_CH_##CH,
+enum zphs01b_channel { ZPHS01B_CHANNEL_LIST(ZPHS01B_CH_ENUM_) ZPHS01B_CH_COUNT };
+
+// Linhas de níveis e de valores da mensagem de saída, montadas a partir da tabela.
+// Cada trecho começa com ", "; o "+ 2" descarta o separador do primeiro canal.
+#define ZPHS01B_LVL_FMT_(id, CH, type, ofs, width, num, den, bias, has_lvl, filt, lvl_label, value_fmt) ZPHS01B_IF_##has_lvl(", " lvl_label " %s")
+#define ZPHS01B_VAL_FMT_(id, CH, type, ofs, width, num, den, bias, has_lvl, filt, lvl_label, value_fmt) ", " value_fmt
+#define ZPHS01B_MSG_LEVELS_FMT (ZPHS01B_CHANNEL_LIST(ZPHS01B_LVL_FMT_) + 2)
+#define ZPHS01B_MSG_VALUES_FMT (ZPHS01B_CHANNEL_LIST(ZPHS01B_VAL_FMT_) + 2)
+
+// Descrição de um canal em tempo de execução (para ferramentas que iteram sobre os canais)
+struct zphs01b_channel_info {
+    const char *name;       // identificador (pm1_0, co2, ...)
+    const char *value_fmt;  // trecho da linha de valores
+    uint8_t ofs, width;
+    int16_t num, den, bias;
+};
+
+extern const struct zphs01b_channel_info zphs01b_channels[ZPHS01B_CH_COUNT];
+
+// Comando exato em bytes para solicitar os dados do sensor ZPHS01B
+extern const uint8_t ZPHS01B_DATA_REQUEST[ZPHS01B_REQUEST_LEN];
+
+/**
+ * @brief Calcula o checksum de um pacote: soma dos bytes 1..len-2, invertida + 1.
+ */
+uint8_t zphs01b_checksum(const uint8_t *packet, size_t len);
+
+/**
+ * @brief Valida uma resposta do sensor (tamanho, cabeçalho e checksum).
+ * @return 0 se a resposta estiver ok, 1 se houver erro.
+ */
+uint8_t zphs01b_check_frame(const uint8_t *frame, int frame_len);
+
+/**
+ * @brief Lê o valor bruto de um canal na resposta (big-endian, 1 ou 2 bytes).
+ */
+static inline uint16_t zphs01b_raw_value(const uint8_t *frame, uint8_t ofs, uint8_t width) {
+    return width == 1 ? frame[ofs] : (uint16_t)(frame[ofs] * 256 + frame[ofs + 1]);
+}
+
+/**
+ * @brief Converte uma resposta válida em valores físicos, um por canal habilitado (sem calibração).
+ */
+void zphs01b_decode(const uint8_t *frame, double values[ZPHS01B_CH_COUNT]);
+
+// Níveis de poluição (Baixo, Médio, Alto, Erro) dos canais com has_lvl = 1
+enum zphs01b_lvl {ZPHS01B_LVL_LO = 0, ZPHS01B_LVL_ME = 1, ZPHS01B_LVL_HI = 2, ZPHS01B_LVL_ER = 3};
+// Texto de cada nível na linha de níveis da mensagem de saída
+extern const char *const zphs01b_lvl_names[4];
+
+/**
+ * @brief Funções que classificam os valores finais em níveis (Baixo, Médio, Alto).
+ * Os valores de referência são baseados em padrões de qualidade do ar.
+ * Cada uma só é compilada se o canal correspondente estiver habilitado; o firmware e o
+ * gerador de capturas sintéticas (tools/zphs01b_decode) usam as mesmas.
+ */
+#if ZPHS01B_EN_PM1_0
+static inline enum zphs01b_lvl zphs01b_pm1_0_lvl(uint16_t pm1_0) {
+    if (pm1_0 <= 10) return ZPHS01B_LVL_LO;
+    else if (pm1_0 <= 25) return ZPHS01B_LVL_ME;
+    else if (pm1_0 <= 1000) return ZPHS01B_LVL_HI;
+    else return ZPHS01B_LVL_ER;
+}
+#endif
+
+#if ZPHS01B_EN_PM2_5
+static inline enum zphs01b_lvl zphs01b_pm2_5_lvl(uint16_t pm2_5) {
+    if (pm2_5 < 14) return ZPHS01B_LVL_LO;
+    else if (pm2_5 < 25) return ZPHS01B_LVL_ME;
+    else if (pm2_5 <= 1000) return ZPHS01B_LVL_HI;
+    else return ZPHS01B_LVL_ER;
+}
+#endif
+
+#if ZPHS01B_EN_PM10
+static inline enum zphs01b_lvl zphs01b_pm10_lvl(uint16_t pm10) {
+    if (pm10 < 20) return ZPHS01B_LVL_LO;
+    else if (pm10 < 50) return ZPHS01B_LVL_ME;
+    else if (pm10 <= 1000) return ZPHS01B_LVL_HI;
+    else return ZPHS01B_LVL_ER;
+}
+#endif
+
+#if ZPHS01B_EN_CO2
+static inline enum zphs01b_lvl zphs01b_co2_lvl(uint16_t co2) {
+    if (co2 <= 700) return ZPHS01B_LVL_LO;
+    else if (co2 <= 1200) return ZPHS01B_LVL_ME;
+    else if (co2 <= 5000) return ZPHS01B_LVL_HI;
+    else return ZPHS01B_LVL_ER;
+}
+#endif
+
+#if ZPHS01B_EN_VOC
+static inline enum zphs01b_lvl zphs01b_voc_lvl(uint8_t voc) {
+    if (voc == 0) return ZPHS01B_LVL_LO;
+    else if (voc == 1) return ZPHS01B_LVL_ME;
+    else if (voc == 2 || voc == 3) return ZPHS01B_LVL_HI;
+    else return ZPHS01B_LVL_ER;
+}
+#endif
+
+#if ZPHS01B_EN_CH2O
+static inline enum zphs01b_lvl zphs01b_ch2o_lvl(uint16_t ch2o) {
+    if (ch2o < 10) return ZPHS01B_LVL_LO;
+    else if (ch2o < 36) return ZPHS01B_LVL_ME;
+    else if (ch2o <= 6250) return ZPHS01B_LVL_HI;
+    else return ZPHS01B_LVL_ER;
+}
+#endif
+
+#if ZPHS01B_EN_CO
+static inline enum zphs01b_lvl zphs01b_co_lvl(double co) {
+    if (co >= 0 && co < 9) return ZPHS01B_LVL_LO;
+    else if (co < 25) return ZPHS01B_LVL_ME;
+    else if (co <= 500) return ZPHS01B_LVL_HI;
+    else return ZPHS01B_LVL_ER;
+}
+#endif
+
+#if ZPHS01B_EN_O3
+static inline enum zphs01b_lvl zphs01b_o3_lvl(uint16_t o3) {
+    if (o3 < 21) return ZPHS01B_LVL_LO;
+    else if (o3 < 55) return ZPHS01B_LVL_ME;
+    else if (o3 <= 10000) return ZPHS01B_LVL_HI;
+    else return ZPHS01B_LVL_ER;
+}
+#endif
+
+#if ZPHS01B_EN_NO2
+static inline enum zphs01b_lvl zphs01b_no2_lvl(uint16_t no2) {
+    if (no2 < 51) return ZPHS01B_LVL_LO;
+    else if (no2 < 100) return ZPHS01B_LVL_ME;
+    else if (no2 <= 10000) return ZPHS01B_LVL_HI;
+    else return ZPHS01B_LVL_ER;
+}
+#endif
+
+#if ZPHS01B_EN_HUMIDITY
+static inline enum zphs01b_lvl zphs01b_humidity_lvl(uint16_t rh) {
+    if (rh < 30) return ZPHS01B_LVL_LO;
+    else if (rh <= 68) return ZPHS01B_LVL_ME;
+    else if (rh <= 100) return ZPHS01B_LVL_HI;
+    else return ZPHS01B_LVL_ER;
+}
+#endif
+
+#endif /* ZPHS01B_PROTO_H */
@@ -0,0 +1,29 @@
+#!/usr/bin/env bash
+# Compara a configuração completa de canais do ZPHS01B com a mínima (sdkconfig.channels_minimal):
+# tamanho de código e RAM no ESP32 (idf.py size) e ciclos por leitura no host (teste de resistência curto).
+# Os ciclos no ESP32 não saem daqui: com o firmware gravado, o comando "X" registra no log os ciclos
+# por leitura medidos com esp_cpu_get_cycle_count.
+#
+#   tools/channel_report.sh [segundos_simulados]
+set -euo pipefail
+
+SIM_SECONDS=${1:-600}
+ROOT=$(cd "$(dirname "$0")/.." && pwd)
+
+for cfg in full minimal; do
+    BUILD=$ROOT/build-ch-$cfg
+    DEFAULTS="$ROOT/sdkconfig"
+    [ "$cfg" = minimal ] && DEFAULTS="$DEFAULTS;$ROOT/sdkconfig.channels_minimal"
+    rm -f "$BUILD/sdkconfig"
+
+    echo "=== $cfg: ESP32"
+    idf.py -C "$ROOT" -B "$BUILD" -DSDKCONFIG="$BUILD/sdkconfig" -DSDKCONFIG_DEFAULTS="$DEFAULTS" build >/dev/null
+    idf.py -C "$ROOT" -B "$BUILD" -DSDKCONFIG="$BUILD/sdkconfig" size
+    idf.py -C "$ROOT" -B "$BUILD" -DSDKCONFIG="$BUILD/sdkconfig" size-files | grep -E "Object File|zphs01b" || true
+
+    echo "=== $cfg: host (ciclos por leitura)"
+    LINUX_DEFAULTS=""
+    [ "$cfg" = minimal ] && LINUX_DEFAULTS="$ROOT/sdkconfig.channels_minimal"
+    BUILD_LINUX="$ROOT/build-linux-ch-$cfg" LINUX_SDKCONFIG_DEFAULTS="$LINUX_DEFAULTS" \
+        "$ROOT/tools/soak.sh" "$SIM_SECONDS" 50 0 | grep -E "canais|latencia"
+done
@@ -0,0 +1,46 @@
+#!/usr/bin/env bash
+# Teste de resistência no host: aplicação compilada para o alvo linux do ESP-IDF
+# conversando com o emulador do ZPHS01B por um pseudo-terminal.
+#
+#   tools/soak.sh [segundos_simulados] [fator_de_aceleracao] [probabilidade_de_falhas]
+#
+# Exemplo: uma hora simulada, 50x mais rápido, 2% de cada tipo de falha:
+#   tools/soak.sh 3600 50 0.02
+#
+# A pausa entre leituras é o intervalo dividido pelo fator de aceleração, então a "aceleracao"
+# impressa no fim acompanha o fator pedido. ZPHS01B_SOAK_PAUSE_MS=0 tira a pausa (carga máxima).
+#
+# Reinícios sob carga: a tarefa do sensor é parada e recriada a cada leitura, sem pausa, com o
+# log adiado recebendo registros; o teste falha se o anel travar (expandidos != gravados -
+# descartados) ou se o heap crescer mais que a tolerância entre a metade e o fim dos reinícios:
+#   ZPHS01B_SOAK_RESTARTS=720 ZPHS01B_SOAK_PAUSE_MS=0 tools/soak.sh 3600 1000 0
+set -euo pipefail
+
+SIM_SECONDS=${1:-3600}
+SPEED=${2:-50}
+FAULTS=${3:-0.02}
+
+ROOT=$(cd "$(dirname "$0")/.." && pwd)
+BUILD_EMU=${BUILD_EMU:-$ROOT/build-emu}
+BUILD_LINUX=${BUILD_LINUX:-$ROOT/build-linux}
+PTY=${ZPHS01B_PTY:-/tmp/zphs01b-soak}
+
+cmake -S "$ROOT/tools/zphs01b_emu" -B "$BUILD_EMU" -DCMAKE_BUILD_TYPE=Release >/dev/null
+cmake --build "$BUILD_EMU" >/dev/null
+
+# sdkconfig próprio para não sobrescrever a configuração do ESP32 versionada no repositório.
+# LINUX_SDKCONFIG_DEFAULTS pode apontar um fragmento (ex.: sdkconfig.channels_minimal).
+DEFAULTS_ARG=()
+[ -n "${LINUX_SDKCONFIG_DEFAULTS:-}" ] && DEFAULTS_ARG=(-DSDKCONFIG_DEFAULTS="$LINUX_SDKCONFIG_DEFAULTS")
+idf.py -C "$ROOT" -B "$BUILD_LINUX" -DIDF_TARGET=linux -DSDKCONFIG="$BUILD_LINUX/sdkconfig" "${DEFAULTS_ARG[@]}" build >/dev/null
+
+"$BUILD_EMU/zphs01b_emu" --link "$PTY" --speed "$SPEED" --faults "$FAULTS" --seed 1 &
+EMU_PID=$!
+trap 'kill $EMU_PID 2>/dev/null || true' EXIT
+while [ ! -e "$PTY" ]; do sleep 0.05; done
+
+ZPHS01B_PTY="$PTY" \
+ZPHS01B_TIME_SCALE="$SPEED" \
+ZPHS01B_SOAK_SECONDS="$SIM_SECONDS" \
+ZPHS01B_BT_QUIET=1 \
+    "$BUILD_LINUX/ZPHS01B_with_BT_example.elf" </dev/null
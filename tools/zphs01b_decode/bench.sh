@@ -0,0 +1,26 @@
+#!/usr/bin/env bash
+# Mede a vazão do decodificador com uma captura sintética grande.
+#   tools/zphs01b_decode/bench.sh [registros] [text|frames]
+set -euo pipefail
+
+RECORDS=${1:-2000000}
+FORMAT=${2:-text}
+ROOT=$(cd "$(dirname "$0")/../.." && pwd)
+BUILD=${BUILD_DECODE:-$ROOT/build-decode}
+WORK=${BENCH_DIR:-$(mktemp -d)}
+
+cmake -S "$ROOT/tools/zphs01b_decode" -B "$BUILD" -DCMAKE_BUILD_TYPE=Release >/dev/null
+cmake --build "$BUILD" >/dev/null
+
+"$BUILD/zphs01b_decode" --synth "$WORK/capture.$FORMAT" --records "$RECORDS" -f "$FORMAT"
+ls -l "$WORK/capture.$FORMAT"
+
+echo "== apenas interpretacao"
+"$BUILD/zphs01b_decode" -f "$FORMAT" "$WORK/capture.$FORMAT"
+echo "== colunas binarias"
+"$BUILD/zphs01b_decode" -f "$FORMAT" -o "$WORK/columns" "$WORK/capture.$FORMAT"
+echo "== CSV"
+"$BUILD/zphs01b_decode" -f "$FORMAT" --csv "$WORK/capture.csv" --stats "$WORK/capture.$FORMAT"
+
+[ -z "${BENCH_DIR:-}" ] && rm -rf "$WORK"
+exit 0
@@ -0,0 +1,465 @@
+/*
+ * Decodificador de capturas do ZPHS01B para o host.
+ *
+ * Lê capturas da saída SPP (texto gerado por construct_output_message) ou respostas
+ * brutas do sensor (sequência de pacotes de 26 bytes) via mmap e gera colunas por canal:
+ * um arquivo float32 little-endian por canal (-o DIR) e/ou um CSV (--csv FILE).
+ *
+ * O formato do texto e a posição dos campos binários vêm de main/zphs01b_proto.h, a mesma
+ * tabela usada pelo firmware. O laço de interpretação não aloca memória: trabalha direto
+ * sobre o arquivo mapeado e escreve em buffers estáticos.
+ *
+ * Também gera capturas sintéticas (--synth) para medir a vazão (ver bench.sh).
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "zphs01b_proto.h"
+
+#define COL_BUF_LEN   (16384)      // amostras por canal antes de gravar
+#define CSV_BUF_LEN   (1 << 20)
+#define FRAG_MAX      (24)
+#define PREFIX_WINDOW (48)         // bytes do início da linha onde o primeiro rótulo é procurado
+#define RELEASE_CHUNK ((size_t)64 << 20) // páginas já interpretadas são devolvidas ao kernel a cada 64 MB
+
+enum input_format { FMT_AUTO, FMT_TEXT, FMT_FRAMES };
+
+// Trecho da linha de valores de um canal, derivado de value_fmt: <pre><número><suf>
+struct fragment {
+    char pre[FRAG_MAX], suf[FRAG_MAX];
+    uint8_t pre_len, suf_len;
+};
+
+static struct fragment frags[ZPHS01B_CH_COUNT];
+
+// Saídas e estatísticas
+static FILE *col_files[ZPHS01B_CH_COUNT];
+static float col_buf[ZPHS01B_CH_COUNT][COL_BUF_LEN];
+static size_t col_len = 0;
+static FILE *csv_file = NULL;
+static char csv_buf[CSV_BUF_LEN];
+static size_t csv_len = 0;
+
+static struct {
+    uint64_t records, rejected, bytes;
+    double min[ZPHS01B_CH_COUNT], max[ZPHS01B_CH_COUNT], sum[ZPHS01B_CH_COUNT];
+} st;
+
+// Arquivo mapeado em interpretação e quanto do seu início já foi devolvido (MADV_DONTNEED)
+static const uint8_t *map_base = NULL;
+static size_t map_released = 0;
+
+/**
+ * Devolve as páginas antes de pos, já interpretadas, para que capturas de vários GB
+ * não fiquem residentes inteiras. Chamada a cada linha/pacote; só age a cada RELEASE_CHUNK.
+ */
+static inline void release_parsed(const void *pos) {
+    size_t done = (size_t)((const uint8_t *)pos - map_base);
+    if (done - map_released < RELEASE_CHUNK) return;
+    size_t upto = done & ~((size_t)sysconf(_SC_PAGESIZE) - 1);
+    madvise((void *)(map_base + map_released), upto - map_released, MADV_DONTNEED);
+    map_released = upto;
+}
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Separa "pm1.0 %d ug/m3" em "pm1.0 " e " ug/m3" ("%%" vira "%")
+static int compile_fragment(const char *fmt, struct fragment *f) {
+    const char *p = fmt;
+    char *dst = f->pre;
+    uint8_t *len = &f->pre_len;
+    int seen_conv = 0;
+
+    *len = 0;
+    while (*p != '\0') {
+        if (p[0] == '%' && p[1] == '%') {
+            if (*len >= FRAG_MAX - 1) return -1;
+            dst[(*len)++] = '%';
+            p += 2;
+        } else if (p[0] == '%') {
+            if (seen_conv) return -1;
+            seen_conv = 1;
+            // Pula flags, precisão e o especificador (%d, %.1f, ...)
+            p++;
+            while (*p != '\0' && strchr("0123456789.-+ l", *p) != NULL) p++;
+            if (*p == '\0') return -1;
+            p++;
+            dst[*len] = '\0';
+            dst = f->suf;
+            len = &f->suf_len;
+            *len = 0;
+        } else {
+            if (*len >= FRAG_MAX - 1) return -1;
+            dst[(*len)++] = *p++;
+        }
+    }
+    dst[*len] = '\0';
+    return seen_conv ? 0 : -1;
+}
+
+static int match(const char **p, const char *end, const char *lit, size_t len) {
+    if ((size_t)(end - *p) < len || memcmp(*p, lit, len) != 0) return 0;
+    *p += len;
+    return 1;
+}
+
+// Número decimal com sinal e parte fracionária opcionais (formatos %d e %.Nf)
+static int parse_number(const char **p, const char *end, double *out) {
+    const char *s = *p;
+    int neg = 0;
+    int64_t ip = 0, fp = 0, div = 1;
+
+    if (s < end && *s == '-') { neg = 1; s++; }
+    if (s >= end || *s < '0' || *s > '9') return 0;
+    while (s < end && *s >= '0' && *s <= '9') ip = ip * 10 + (*s++ - '0');
+    if (s < end && *s == '.') {
+        s++;
+        while (s < end && *s >= '0' && *s <= '9' && div < 1000000000) { fp = fp * 10 + (*s++ - '0'); div *= 10; }
+    }
+    *out = (ip + (double)fp / div) * (neg ? -1 : 1);
+    *p = s;
+    return 1;
+}
+
+static void flush_columns(void) {
+    if (col_len == 0) return;
+    for (int c = 0; c < ZPHS01B_CH_COUNT; c++) {
+        if (col_files[c] != NULL) fwrite(col_buf[c], sizeof(float), col_len, col_files[c]);
+    }
+    col_len = 0;
+}
+
+static void flush_csv(void) {
+    if (csv_file != NULL && csv_len > 0) fwrite(csv_buf, 1, csv_len, csv_file);
+    csv_len = 0;
+}
+
+// Escreve v com até 3 casas decimais, sem zeros à direita (os valores do sensor têm no máximo 2)
+static size_t format_value(char *out, double v) {
+    char tmp[32];
+    size_t n = 0, len = 0;
+    if (v < 0) { out[len++] = '-'; v = -v; }
+    uint64_t scaled = (uint64_t)(v * 1000 + 0.5);
+    uint64_t ip = scaled / 1000;
+    unsigned fp = (unsigned)(scaled % 1000);
+    do { tmp[n++] = (char)('0' + ip % 10); ip /= 10; } while (ip > 0);
+    while (n > 0) out[len++] = tmp[--n];
+    if (fp != 0) {
+        out[len++] = '.';
+        out[len++] = (char)('0' + fp / 100);
+        if (fp % 100 != 0) {
+            out[len++] = (char)('0' + fp / 10 % 10);
+            if (fp % 10 != 0) out[len++] = (char)('0' + fp % 10);
+        }
+    }
+    return len;
+}
+
+static void emit(const double v[ZPHS01B_CH_COUNT]) {
+    for (int c = 0; c < ZPHS01B_CH_COUNT; c++) {
+        if (st.records == 0 || v[c] < st.min[c]) st.min[c] = v[c];
+        if (st.records == 0 || v[c] > st.max[c]) st.max[c] = v[c];
+        st.sum[c] += v[c];
+    }
+    if (col_files[0] != NULL) {
+        for (int c = 0; c < ZPHS01B_CH_COUNT; c++) col_buf[c][col_len] = (float)v[c];
+        if (++col_len == COL_BUF_LEN) flush_columns();
+    }
+    if (csv_file != NULL) {
+        if (csv_len > CSV_BUF_LEN - 512) flush_csv();
+        csv_len += format_value(csv_buf + csv_len, (double)st.records);
+        for (int c = 0; c < ZPHS01B_CH_COUNT; c++) {
+            csv_buf[csv_len++] = ',';
+            csv_len += format_value(csv_buf + csv_len, v[c]);
+        }
+        csv_buf[csv_len++] = '\n';
+    }
+    st.records++;
+}
+
+// Interpreta uma linha de valores: "<frag0>, <frag1>, ..., <fragN>;"
+// Retorna 1 se ok, 0 se não é uma linha de valores (ex.: a linha de níveis) e -1 se está truncada ou corrompida.
+static int parse_values_line(const char *p, const char *end, double v[ZPHS01B_CH_COUNT]) {
+    for (int c = 0; c < ZPHS01B_CH_COUNT; c++) {
+        if (c > 0 && !match(&p, end, ", ", 2)) return -1;
+        if (!match(&p, end, frags[c].pre, frags[c].pre_len)) return c > 0 ? -1 : 0;
+        if (!parse_number(&p, end, &v[c])) return c > 0 ? -1 : 0;
+        if (!match(&p, end, frags[c].suf, frags[c].suf_len)) return -1;
+    }
+    return (p < end && *p == ';') ? 1 : -1;
+}
+
+static void decode_text(const char *data, size_t size) {
+    const char *p = data, *end = data + size;
+    const struct fragment *first = &frags[0];
+    double v[ZPHS01B_CH_COUNT];
+
+    while (p < end) {
+        const char *eol = memchr(p, '\n', (size_t)(end - p));
+        if (eol == NULL) eol = end;
+
+        // O primeiro rótulo pode vir depois de um carimbo de tempo do aplicativo de captura
+        size_t window = (size_t)(eol - p) < PREFIX_WINDOW ? (size_t)(eol - p) : PREFIX_WINDOW;
+        const char *start = first->pre_len > 0 ? memmem(p, window, first->pre, first->pre_len) : p;
+        if (start != NULL) {
+            int rv = parse_values_line(start, eol, v);
+            if (rv > 0) emit(v);
+            else if (rv < 0) st.rejected++;
+        }
+        p = eol + 1;
+        release_parsed(p < end ? p : end);
+    }
+}
+
+static void decode_frames(const uint8_t *data, size_t size) {
+    double v[ZPHS01B_CH_COUNT];
+    size_t i = 0;
+
+    while (i + ZPHS01B_FRAME_LEN <= size) {
+        const uint8_t *hit = memchr(data + i, ZPHS01B_FRAME_START, size - i - ZPHS01B_FRAME_LEN + 1);
+        if (hit == NULL) break;
+        i = (size_t)(hit - data);
+        if (zphs01b_check_frame(hit, ZPHS01B_FRAME_LEN) == 0) {
+            zphs01b_decode(hit, v);
+            emit(v);
+            i += ZPHS01B_FRAME_LEN;
+        } else {
+            // Ruído ou pacote corrompido: procura o próximo início a partir do byte seguinte
+            if (hit[1] == ZPHS01B_CMD_READ) st.rejected++;
+            i++;
+        }
+        release_parsed(data + i);
+    }
+}
+
+static int decode_file(const char *path, enum input_format fmt) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) { perror(path); return -1; }
+    struct stat sb;
+    if (fstat(fd, &sb) < 0) { perror(path); close(fd); return -1; }
+    size_t size = (size_t)sb.st_size;
+    if (size == 0) { close(fd); return 0; }
+
+    // Sem MAP_POPULATE: as páginas são lidas sob demanda, com leitura antecipada sequencial
+    const uint8_t *data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) { perror(path); return -1; }
+    madvise((void *)data, size, MADV_SEQUENTIAL);
+    map_base = data;
+    map_released = 0;
+
+    if (fmt == FMT_AUTO) {
+        fmt = (size >= 2 && data[0] == ZPHS01B_FRAME_START && data[1] == ZPHS01B_CMD_READ) ? FMT_FRAMES : FMT_TEXT;
+    }
+    if (fmt == FMT_FRAMES) decode_frames(data, size);
+    else decode_text((const char *)data, size);
+
+    st.bytes += size;
+    munmap((void *)data, size);
+    return 0;
+}
+
+static int open_outputs(const char *dir, const char *csv_path) {
+    if (dir != NULL) {
+        if (mkdir(dir, 0755) < 0 && errno != EEXIST) { perror(dir); return -1; }
+        for (int c = 0; c < ZPHS01B_CH_COUNT; c++) {
+            char path[4096];
+            snprintf(path, sizeof(path), "%s/%s.f32", dir, zphs01b_channels[c].name);
+            if ((col_files[c] = fopen(path, "wb")) == NULL) { perror(path); return -1; }
+        }
+    }
+    if (csv_path != NULL) {
+        if ((csv_file = fopen(csv_path, "w")) == NULL) { perror(csv_path); return -1; }
+        csv_len += (size_t)snprintf(csv_buf, CSV_BUF_LEN, "index");
+        for (int c = 0; c < ZPHS01B_CH_COUNT; c++) {
+            csv_len += (size_t)snprintf(csv_buf + csv_len, CSV_BUF_LEN - csv_len, ",%s", zphs01b_channels[c].name);
+        }
+        csv_buf[csv_len++] = '\n';
+    }
+    return 0;
+}
+
+static void close_outputs(const char *dir) {
+    flush_columns();
+    flush_csv();
+    for (int c = 0; c < ZPHS01B_CH_COUNT; c++) {
+        if (col_files[c] != NULL) fclose(col_files[c]);
+    }
+    if (csv_file != NULL) fclose(csv_file);
+    if (dir != NULL) {
+        // Manifesto das colunas: nome, formato de origem e quantidade de amostras
+        char path[4096];
+        snprintf(path, sizeof(path), "%s/manifest.csv", dir);
+        FILE *m = fopen(path, "w");
+        if (m == NULL) { perror(path); return; }
+        fprintf(m, "channel,file,type,samples,source_format\n");
+        for (int c = 0; c < ZPHS01B_CH_COUNT; c++) {
+            fprintf(m, "%s,%s.f32,float32le,%" PRIu64 ",\"%s\"\n", zphs01b_channels[c].name,
+                    zphs01b_channels[c].name, st.records, zphs01b_channels[c].value_fmt);
+        }
+        fclose(m);
+    }
+}
+
+// --- Captura sintética ---
+
+// Passeio aleatório por canal, em unidades brutas: {inicial, passo, mínimo, máximo}
+#define WALK_PM1_0    {8, 2, 0, 300}
+#define WALK_PM2_5    {12, 3, 0, 500}
+#define WALK_PM10     {18, 4, 0, 1000}
+#define WALK_CO2      {600, 20, 400, 5200}  // acima de 5000 ppm o firmware classifica como "error"
+#define WALK_VOC      {0, 1, 0, 3}
+#define WALK_CH2O     {8, 2, 0, 200}
+#define WALK_CO       {20, 3, 0, 1000}
+#define WALK_O3       {2, 1, 0, 100}
+#define WALK_NO2      {3, 1, 0, 100}
+#define WALK_TEMP     {750, 2, 500, 1100}
+#define WALK_HUMIDITY {50, 1, 0, 100}
+#define WALK_(id, CH, type, ofs, width, num, den, bias, has_lvl, filt, lvl_label, value_fmt) [ZPHS01B_CH_##CH] = WALK_##CH,
+static const uint16_t synth_walk[ZPHS01B_CH_COUNT][4] = { ZPHS01B_CHANNEL_LIST(WALK_) };
+
+static uint16_t walk_step(uint16_t v, const uint16_t *w) {
+    int n = (int)v + (rand() % (2 * w[1] + 1)) - w[1];
+    return (uint16_t)(n < w[2] ? w[2] : n > w[3] ? w[3] : n);
+}
+
+static void put_raw(uint8_t *frame, int c, uint16_t raw) {
+    const struct zphs01b_channel_info *ch = &zphs01b_channels[c];
+    if (ch->width == 1) frame[ch->ofs] = (uint8_t)raw;
+    else { frame[ch->ofs] = (uint8_t)(raw >> 8); frame[ch->ofs + 1] = (uint8_t)raw; }
+}
+
+#define SYNTH_ARG_(id, CH, type, ofs, width, num, den, bias, has_lvl, filt, lvl_label, value_fmt) , (type)v[ZPHS01B_CH_##CH]
+// Níveis com os mesmos limites do firmware, aplicados ao valor convertido para o tipo do canal
+#define SYNTH_LVL_EXPR_(id, CH, type) , zphs01b_lvl_names[zphs01b_##id##_lvl((type)v[ZPHS01B_CH_##CH])]
+#define SYNTH_LVL_(id, CH, type, ofs, width, num, den, bias, has_lvl, filt, lvl_label, value_fmt) ZPHS01B_IF_##has_lvl(SYNTH_LVL_EXPR_(id, CH, type))
+
+static int synthesize(const char *path, uint64_t records, enum input_format fmt, unsigned seed) {
+    FILE *f = fopen(path, "wb");
+    if (f == NULL) { perror(path); return -1; }
+    static char buf[1 << 20];
+    setvbuf(f, buf, _IOFBF, sizeof(buf));
+    srand(seed);
+
+    uint16_t raw[ZPHS01B_CH_COUNT];
+    for (int c = 0; c < ZPHS01B_CH_COUNT; c++) raw[c] = synth_walk[c][0];
+    uint8_t frame[ZPHS01B_FRAME_LEN];
+    double v[ZPHS01B_CH_COUNT];
+
+    for (uint64_t r = 0; r < records; r++) {
+        memset(frame, 0, sizeof(frame));
+        frame[0] = ZPHS01B_FRAME_START;
+        frame[1] = ZPHS01B_CMD_READ;
+        for (int c = 0; c < ZPHS01B_CH_COUNT; c++) {
+            raw[c] = walk_step(raw[c], synth_walk[c]);
+            put_raw(frame, c, raw[c]);
+        }
+        frame[ZPHS01B_FRAME_LEN - 1] = zphs01b_checksum(frame, ZPHS01B_FRAME_LEN);
+
+        if (fmt == FMT_FRAMES) {
+            fwrite(frame, 1, sizeof(frame), f);
+            continue;
+        }
+        // Mesmo texto que construct_output_message envia pelo SPP
+        zphs01b_decode(frame, v);
+        fputs("\n\n", f);
+        fprintf(f, ZPHS01B_MSG_LEVELS_FMT ZPHS01B_CHANNEL_LIST(SYNTH_LVL_));
+        fputs(";\n", f);
+        fprintf(f, ZPHS01B_MSG_VALUES_FMT ZPHS01B_CHANNEL_LIST(SYNTH_ARG_));
+        fputs(";\n\n>> Caso queira alterar a frequencia de recebimento de dados, aperte 'X'.\n", f);
+    }
+    fclose(f);
+    return 0;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+        "uso: %s [-f auto|text|frames] [-o DIR] [--csv FILE] [--stats] CAPTURA...\n"
+        "     %s --synth ARQUIVO --records N [-f text|frames] [--seed N]\n"
+        "  -f, --format F   formato da captura (auto: pacotes se comecar com 0xFF 0x86)\n"
+        "  -o, --out DIR    um arquivo float32 por canal em DIR, mais manifest.csv\n"
+        "      --csv FILE   todas as colunas em um CSV\n"
+        "  -s, --stats      minimo, media e maximo por canal\n"
+        "Valores vindos de pacotes brutos nao incluem os offsets de calibracao do firmware.\n",
+        prog, prog);
+}
+
+int main(int argc, char **argv) {
+    static const struct option longopts[] = {
+        {"format", required_argument, NULL, 'f'}, {"out", required_argument, NULL, 'o'},
+        {"csv", required_argument, NULL, 'c'},    {"stats", no_argument, NULL, 's'},
+        {"synth", required_argument, NULL, 'S'},  {"records", required_argument, NULL, 'n'},
+        {"seed", required_argument, NULL, 'r'},   {"help", no_argument, NULL, 'h'},
+        {NULL, 0, NULL, 0},
+    };
+    enum input_format fmt = FMT_AUTO;
+    const char *out_dir = NULL, *csv_path = NULL, *synth_path = NULL;
+    uint64_t records = 1000000;
+    unsigned seed = 1;
+    int show_stats = 0, c;
+
+    while ((c = getopt_long(argc, argv, "f:o:sh", longopts, NULL)) != -1) {
+        switch (c) {
+        case 'f':
+            if (strcmp(optarg, "text") == 0) fmt = FMT_TEXT;
+            else if (strcmp(optarg, "frames") == 0) fmt = FMT_FRAMES;
+            else if (strcmp(optarg, "auto") == 0) fmt = FMT_AUTO;
+            else { usage(argv[0]); return 2; }
+            break;
+        case 'o': out_dir = optarg; break;
+        case 'c': csv_path = optarg; break;
+        case 's': show_stats = 1; break;
+        case 'S': synth_path = optarg; break;
+        case 'n': records = strtoull(optarg, NULL, 10); break;
+        case 'r': seed = (unsigned)strtoul(optarg, NULL, 10); break;
+        default: usage(argv[0]); return 2;
+        }
+    }
+
+    if (synth_path != NULL) {
+        return synthesize(synth_path, records, fmt == FMT_FRAMES ? FMT_FRAMES : FMT_TEXT, seed) < 0;
+    }
+    if (optind >= argc) { usage(argv[0]); return 2; }
+
+    for (int ch = 0; ch < ZPHS01B_CH_COUNT; ch++) {
+        if (compile_fragment(zphs01b_channels[ch].value_fmt, &frags[ch]) < 0) {
+            fprintf(stderr, "formato invalido para %s: %s\n", zphs01b_channels[ch].name, zphs01b_channels[ch].value_fmt);
+            return 1;
+        }
+    }
+    if (open_outputs(out_dir, csv_path) < 0) return 1;
+
+    int rv = 0;
+    double t0 = now_s();
+    for (int i = optind; i < argc; i++) {
+        if (decode_file(argv[i], fmt) < 0) rv = 1;
+    }
+    close_outputs(out_dir);
+    double dt = now_s() - t0;
+
+    fprintf(stderr, "%" PRIu64 " registros, %" PRIu64 " rejeitados, %.1f MB em %.3f s: %.0f MB/s (%.1f GB/min), %.0f registros/s\n",
+            st.records, st.rejected, st.bytes / 1e6, dt, st.bytes / 1e6 / dt, st.bytes / 1e9 / dt * 60, st.records / dt);
+    if (show_stats && st.records > 0) {
+        for (int ch = 0; ch < ZPHS01B_CH_COUNT; ch++) {
+            fprintf(stderr, "  %-9s min %10.1f  media %10.2f  max %10.1f\n", zphs01b_channels[ch].name,
+                    st.min[ch], st.sum[ch] / st.records, st.max[ch]);
+        }
+    }
+    return rv;
+}
@@ -0,0 +1,353 @@
+/*
+ * Emulador do sensor ZPHS01B sobre um pseudo-terminal.
+ *
+ * Cria um pty, publica o lado escravo em um link simbólico (padrão /tmp/zphs01b) e
+ * responde a cada comando de leitura (0xFF 0x01 0x86 ...) com uma resposta de 26 bytes,
+ * gerada a partir de um roteiro ou aleatoriamente. Pode injetar ruído, respostas
+ * parciais, checksums errados, atrasos e perdas, com os tempos acelerados por --speed.
+ *
+ * Usado com o build da aplicação para o alvo linux do ESP-IDF (ver tools/soak.sh).
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <poll.h>
+#include <signal.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "zphs01b_proto.h"
+
+// Latência típica do sensor: 26 bytes a 9600 baud (~27 ms) mais o processamento interno
+#define DEFAULT_LATENCY_MS  (40)
+#define DEFAULT_DELAY_MS    (1500)
+#define MAX_NOISE_BYTES     (8)
+#define MAX_SCRIPT_LINES    (4096)
+
+// Valores de uma resposta, nas unidades brutas do protocolo
+struct raw_sample {
+    uint16_t pm1_0, pm2_5, pm10, co2;
+    uint8_t  voc;
+    uint16_t temp, humidity, ch2o, co, o3, no2;
+};
+
+static struct options {
+    const char *link;
+    const char *script;
+    unsigned seed;
+    double speed;
+    unsigned latency_ms, delay_ms;
+    double p_drop, p_delay, p_noise, p_partial, p_badsum, p_spike;
+    unsigned report_s;
+    unsigned long max_requests;
+} opt = {
+    .link = "/tmp/zphs01b",
+    .speed = 1.0,
+    .latency_ms = DEFAULT_LATENCY_MS,
+    .delay_ms = DEFAULT_DELAY_MS,
+};
+
+static struct counters {
+    unsigned long requests, responses, dropped, delayed, noise, partial, badsum, spikes;
+    unsigned long bytes_in, bytes_out;
+} cnt;
+
+static struct raw_sample script[MAX_SCRIPT_LINES];
+static size_t script_len = 0, script_pos = 0;
+static struct raw_sample walk;
+static volatile sig_atomic_t stop = 0;
+
+static void on_signal(int sig) { (void)sig; stop = 1; }
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void sleep_ms(double ms) {
+    ms /= opt.speed;
+    if (ms <= 0) return;
+    struct timespec ts = {.tv_sec = (time_t)(ms / 1000), .tv_nsec = (long)(((long)(ms * 1000) % 1000000) * 1000)};
+    while (nanosleep(&ts, &ts) < 0 && errno == EINTR && !stop) {}
+}
+
+static int chance(double p) {
+    return p > 0 && (double)rand() / RAND_MAX < p;
+}
+
+static void put16(uint8_t *frame, int ofs, uint16_t v) {
+    frame[ofs] = (uint8_t)(v >> 8);
+    frame[ofs + 1] = (uint8_t)v;
+}
+
+static void encode_frame(const struct raw_sample *s, uint8_t *frame) {
+    memset(frame, 0, ZPHS01B_FRAME_LEN);
+    frame[0] = ZPHS01B_FRAME_START;
+    frame[1] = ZPHS01B_CMD_READ;
+    put16(frame, ZPHS01B_OFS_PM1_0, s->pm1_0);
+    put16(frame, ZPHS01B_OFS_PM2_5, s->pm2_5);
+    put16(frame, ZPHS01B_OFS_PM10, s->pm10);
+    put16(frame, ZPHS01B_OFS_CO2, s->co2);
+    frame[ZPHS01B_OFS_VOC] = s->voc;
+    put16(frame, ZPHS01B_OFS_TEMP, s->temp);
+    put16(frame, ZPHS01B_OFS_HUMIDITY, s->humidity);
+    put16(frame, ZPHS01B_OFS_CH2O, s->ch2o);
+    put16(frame, ZPHS01B_OFS_CO, s->co);
+    put16(frame, ZPHS01B_OFS_O3, s->o3);
+    put16(frame, ZPHS01B_OFS_NO2, s->no2);
+    frame[ZPHS01B_FRAME_LEN - 1] = zphs01b_checksum(frame, ZPHS01B_FRAME_LEN);
+}
+
+// Passeio aleatório limitado, para valores plausíveis e variados
+static uint16_t step(uint16_t v, int amp, uint16_t lo, uint16_t hi) {
+    int n = (int)v + (rand() % (2 * amp + 1)) - amp;
+    if (n < lo) n = lo;
+    if (n > hi) n = hi;
+    return (uint16_t)n;
+}
+
+static void next_sample(struct raw_sample *s) {
+    if (script_len > 0) {
+        *s = script[script_pos];
+        script_pos = (script_pos + 1) % script_len;
+        return;
+    }
+    walk.pm1_0 = step(walk.pm1_0, 2, 0, 1000);
+    walk.pm2_5 = step(walk.pm2_5, 3, walk.pm1_0, 1000);
+    walk.pm10 = step(walk.pm10, 4, walk.pm2_5, 1000);
+    walk.co2 = step(walk.co2, 20, 400, 5000);
+    walk.voc = (uint8_t)step(walk.voc, 1, 0, 3);
+    walk.temp = step(walk.temp, 2, 500, 1150);
+    walk.humidity = step(walk.humidity, 1, 0, 100);
+    walk.ch2o = step(walk.ch2o, 2, 0, 6250);
+    walk.co = step(walk.co, 3, 0, 5000);
+    walk.o3 = step(walk.o3, 1, 0, 1000);
+    walk.no2 = step(walk.no2, 1, 0, 1000);
+    *s = walk;
+}
+
+// Pico isolado em um canal, apenas nesta resposta (o passeio aleatório segue intacto)
+static void add_spike(struct raw_sample *s) {
+    uint16_t *channels[] = {&s->pm1_0, &s->pm2_5, &s->pm10, &s->co2, &s->ch2o, &s->co, &s->o3, &s->no2};
+    uint16_t *v = channels[rand() % (int)(sizeof(channels) / sizeof(channels[0]))];
+    *v = (uint16_t)(*v * 4 + 200);
+}
+
+// Roteiro: uma resposta por linha, valores em unidades de engenharia:
+// pm1.0 pm2.5 pm10 co2 voc temp_C rh ch2o_ug/m3 co_ppm o3_ppm no2_ppm
+static int load_script(const char *path) {
+    FILE *f = fopen(path, "r");
+    if (f == NULL) { perror(path); return -1; }
+    char line[256];
+    while (fgets(line, sizeof(line), f) != NULL && script_len < MAX_SCRIPT_LINES) {
+        unsigned pm1, pm25, pm10, co2, voc, rh, ch2o;
+        double temp, co, o3, no2;
+        if (line[0] == '#') continue;
+        if (sscanf(line, "%u %u %u %u %u %lf %u %u %lf %lf %lf",
+                   &pm1, &pm25, &pm10, &co2, &voc, &temp, &rh, &ch2o, &co, &o3, &no2) != 11) continue;
+        struct raw_sample *s = &script[script_len++];
+        s->pm1_0 = (uint16_t)pm1; s->pm2_5 = (uint16_t)pm25; s->pm10 = (uint16_t)pm10;
+        s->co2 = (uint16_t)co2; s->voc = (uint8_t)voc;
+        s->temp = (uint16_t)(temp * 10 + 500 + 0.5);
+        s->humidity = (uint16_t)rh; s->ch2o = (uint16_t)ch2o;
+        s->co = (uint16_t)(co * 10 + 0.5);
+        s->o3 = (uint16_t)(o3 * 100 + 0.5);
+        s->no2 = (uint16_t)(no2 * 100 + 0.5);
+    }
+    fclose(f);
+    if (script_len == 0) { fprintf(stderr, "%s: nenhuma linha valida\n", path); return -1; }
+    return 0;
+}
+
+static void write_all(int fd, const uint8_t *buf, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(fd, buf, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return;
+        }
+        buf += n;
+        len -= (size_t)n;
+        cnt.bytes_out += (unsigned long)n;
+    }
+}
+
+static void respond(int fd) {
+    uint8_t out[MAX_NOISE_BYTES + ZPHS01B_FRAME_LEN];
+    size_t len = 0;
+    struct raw_sample s;
+
+    cnt.requests++;
+    next_sample(&s);
+    if (chance(opt.p_drop)) { cnt.dropped++; return; }
+    if (chance(opt.p_spike)) { add_spike(&s); cnt.spikes++; }
+
+    if (chance(opt.p_noise)) {
+        size_t n = 1 + (size_t)(rand() % MAX_NOISE_BYTES);
+        for (size_t i = 0; i < n; i++) out[len++] = (uint8_t)rand();
+        cnt.noise++;
+    }
+    encode_frame(&s, out + len);
+    if (chance(opt.p_badsum)) {
+        out[len + ZPHS01B_FRAME_LEN - 1] ^= (uint8_t)(1 + rand() % 255);
+        cnt.badsum++;
+    }
+    len += ZPHS01B_FRAME_LEN;
+    if (chance(opt.p_partial)) {
+        len -= 1 + (size_t)(rand() % (ZPHS01B_FRAME_LEN - 1));
+        cnt.partial++;
+    }
+
+    if (chance(opt.p_delay)) {
+        sleep_ms(opt.delay_ms);
+        cnt.delayed++;
+    } else {
+        sleep_ms(opt.latency_ms);
+    }
+    write_all(fd, out, len);
+    cnt.responses++;
+}
+
+static void report(double t0) {
+    double dt = now_s() - t0;
+    fprintf(stderr, "emu: %.1fs req=%lu resp=%lu drop=%lu delay=%lu noise=%lu partial=%lu badsum=%lu spikes=%lu "
+            "in=%luB out=%luB (%.1f req/s)\n",
+            dt, cnt.requests, cnt.responses, cnt.dropped, cnt.delayed, cnt.noise, cnt.partial, cnt.badsum, cnt.spikes,
+            cnt.bytes_in, cnt.bytes_out, dt > 0 ? cnt.requests / dt : 0.0);
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+        "uso: %s [opcoes]\n"
+        "  -l, --link PATH      link simbolico para o pty (padrao /tmp/zphs01b)\n"
+        "  -f, --script FILE    respostas roteirizadas (uma por linha, repetidas em ciclo)\n"
+        "  -s, --seed N         semente do gerador aleatorio\n"
+        "  -x, --speed F        acelera latencias e atrasos por F (padrao 1)\n"
+        "      --latency-ms N   latencia normal da resposta (padrao %d)\n"
+        "      --delay-ms N     latencia das respostas atrasadas (padrao %d)\n"
+        "      --drop P         probabilidade de nao responder\n"
+        "      --delay P        probabilidade de responder com atraso\n"
+        "      --noise P        probabilidade de bytes de ruido antes da resposta\n"
+        "      --partial P      probabilidade de resposta truncada\n"
+        "      --badsum P       probabilidade de checksum errado\n"
+        "      --faults P       atalho: mesma probabilidade para todas as falhas acima\n"
+        "      --spike P        probabilidade de um pico isolado (resposta valida) em um canal\n"
+        "  -r, --report N       relatorio a cada N segundos (0 = apenas ao sair)\n"
+        "  -n, --count N        encerra apos N comandos\n",
+        prog, DEFAULT_LATENCY_MS, DEFAULT_DELAY_MS);
+}
+
+static int parse_args(int argc, char **argv) {
+    enum { O_LAT = 256, O_DELAY_MS, O_DROP, O_DELAY, O_NOISE, O_PARTIAL, O_BADSUM, O_FAULTS, O_SPIKE };
+    static const struct option longopts[] = {
+        {"link", required_argument, NULL, 'l'},     {"script", required_argument, NULL, 'f'},
+        {"seed", required_argument, NULL, 's'},     {"speed", required_argument, NULL, 'x'},
+        {"latency-ms", required_argument, NULL, O_LAT}, {"delay-ms", required_argument, NULL, O_DELAY_MS},
+        {"drop", required_argument, NULL, O_DROP},  {"delay", required_argument, NULL, O_DELAY},
+        {"noise", required_argument, NULL, O_NOISE}, {"partial", required_argument, NULL, O_PARTIAL},
+        {"badsum", required_argument, NULL, O_BADSUM}, {"faults", required_argument, NULL, O_FAULTS},
+        {"spike", required_argument, NULL, O_SPIKE},   {"report", required_argument, NULL, 'r'},
+        {"count", required_argument, NULL, 'n'},
+        {"help", no_argument, NULL, 'h'},           {NULL, 0, NULL, 0},
+    };
+    int c;
+    opt.seed = (unsigned)time(NULL);
+    while ((c = getopt_long(argc, argv, "l:f:s:x:r:n:h", longopts, NULL)) != -1) {
+        switch (c) {
+        case 'l': opt.link = optarg; break;
+        case 'f': opt.script = optarg; break;
+        case 's': opt.seed = (unsigned)strtoul(optarg, NULL, 10); break;
+        case 'x': opt.speed = atof(optarg); break;
+        case 'r': opt.report_s = (unsigned)atoi(optarg); break;
+        case 'n': opt.max_requests = strtoul(optarg, NULL, 10); break;
+        case O_LAT: opt.latency_ms = (unsigned)atoi(optarg); break;
+        case O_DELAY_MS: opt.delay_ms = (unsigned)atoi(optarg); break;
+        case O_DROP: opt.p_drop = atof(optarg); break;
+        case O_DELAY: opt.p_delay = atof(optarg); break;
+        case O_NOISE: opt.p_noise = atof(optarg); break;
+        case O_PARTIAL: opt.p_partial = atof(optarg); break;
+        case O_BADSUM: opt.p_badsum = atof(optarg); break;
+        case O_SPIKE: opt.p_spike = atof(optarg); break;
+        case O_FAULTS:
+            opt.p_drop = opt.p_delay = opt.p_noise = opt.p_partial = opt.p_badsum = atof(optarg);
+            break;
+        default: usage(argv[0]); return -1;
+        }
+    }
+    if (opt.speed <= 0) { fprintf(stderr, "--speed deve ser positivo\n"); return -1; }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    if (parse_args(argc, argv) < 0) return 2;
+    if (opt.script != NULL && load_script(opt.script) < 0) return 2;
+    srand(opt.seed);
+    walk = (struct raw_sample){.pm1_0 = 8, .pm2_5 = 12, .pm10 = 18, .co2 = 600, .voc = 0,
+                               .temp = 750, .humidity = 50, .ch2o = 8, .co = 20, .o3 = 2, .no2 = 3};
+
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master < 0 || grantpt(master) < 0 || unlockpt(master) < 0) { perror("posix_openpt"); return 1; }
+    const char *slave_path = ptsname(master);
+
+    // Mantém o lado escravo aberto: o pty sobrevive entre execuções da aplicação
+    int slave = open(slave_path, O_RDWR | O_NOCTTY);
+    struct termios tio;
+    if (slave >= 0 && tcgetattr(slave, &tio) == 0) {
+        cfmakeraw(&tio);
+        tcsetattr(slave, TCSANOW, &tio);
+    }
+    unlink(opt.link);
+    if (symlink(slave_path, opt.link) < 0) { perror(opt.link); return 1; }
+    fprintf(stderr, "emu: %s -> %s (seed %u, speed %.1fx)\n", opt.link, slave_path, opt.seed, opt.speed);
+
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+
+    // Janela deslizante com os últimos bytes recebidos, para reconhecer o comando mesmo após lixo
+    uint8_t win[ZPHS01B_REQUEST_LEN] = {0};
+    size_t win_len = 0;
+    double t0 = now_s(), last_report = t0;
+
+    while (!stop && (opt.max_requests == 0 || cnt.requests < opt.max_requests)) {
+        struct pollfd pfd = {.fd = master, .events = POLLIN};
+        int rv = poll(&pfd, 1, 200);
+        if (opt.report_s > 0 && now_s() - last_report >= opt.report_s) {
+            report(t0);
+            last_report = now_s();
+        }
+        if (rv <= 0) continue;
+
+        uint8_t buf[256];
+        ssize_t n = read(master, buf, sizeof(buf));
+        if (n <= 0) {
+            if (n < 0 && errno != EINTR && errno != EAGAIN && errno != EIO) break;
+            continue;
+        }
+        cnt.bytes_in += (unsigned long)n;
+        for (ssize_t i = 0; i < n; i++) {
+            if (win_len == ZPHS01B_REQUEST_LEN) {
+                memmove(win, win + 1, ZPHS01B_REQUEST_LEN - 1);
+                win_len--;
+            }
+            win[win_len++] = buf[i];
+            if (win_len == ZPHS01B_REQUEST_LEN && memcmp(win, ZPHS01B_DATA_REQUEST, ZPHS01B_REQUEST_LEN) == 0) {
+                respond(master);
+                win_len = 0;
+            }
+        }
+    }
+
+    report(t0);
+    unlink(opt.link);
+    if (slave >= 0) close(slave);
+    close(master);
+    return 0;
+}